@@ -156,6 +156,16 @@ extern "C" void setup_hoa0x2ein(void)
     hoa_in_class = c;
 }
 
+//! Returns true if hoa.in~ and hoa.out~ use their own dsp method for the multichannel signals rather than the DSP of the wrapper.
+static bool hoa_io_ismulti(void)
+{
+#ifdef CLASS_MULTICHANNEL
+    return hoa_signal_setmultiout() != NULL;
+#else
+    return false;
+#endif
+}
+
 static void *hoa_out_tilde_new(t_symbol *s, int argc, t_atom *argv)
 {
     t_hoa_out_tilde *x = NULL;
@@ -163,9 +173,13 @@ static void *hoa_out_tilde_new(t_symbol *s, int argc, t_atom *argv)
     x = (t_hoa_out_tilde *)eobj_new(hoa_outtilde_class);
 	if(x)
 	{
-        eobj_dspsetup(x, 0, 0);
-        x->f_extra = 0;
-        x->f_signal = NULL;
+        if(!hoa_io_ismulti())
+            eobj_dspsetup(x, 0, 0);
+        x->f_extra      = 0;
+        x->f_signal     = NULL;
+        x->f_signals    = NULL;
+        x->f_nchannels  = 0;
+        x->f_float      = 0;
         if(argc > 1 && argv && atom_gettype(argv) == A_SYM && atom_gettype(argv+1) == A_FLOAT && atom_getsym(argv) == gensym("extra") && atom_getfloat(argv+1) > 0)
         {
             x->f_extra = atom_getfloat(argv+1);
@@ -194,18 +208,65 @@ static void hoa_out_tilde_dsp(t_hoa_out_tilde *x, t_object *dsp, short *count, d
     }
 }
 
+#ifdef CLASS_MULTICHANNEL
+static t_int* hoa_out_tilde_perform_single(t_int* w)
+{
+    t_hoa_out_tilde* x  = (t_hoa_out_tilde *)(w[1]);
+    Signal<t_sample>::add(ulong(w[3]), (t_sample *)(w[2]), x->f_signal);
+    return (w+4);
+}
+
+static t_int* hoa_out_tilde_perform_multi(t_int* w)
+{
+    t_hoa_out_tilde* x  = (t_hoa_out_tilde *)(w[1]);
+    t_sample* in        = (t_sample *)(w[2]);
+    const ulong n       = ulong(w[3]);
+    const int nchannels = min(int(w[4]), x->f_nchannels);
+    for(int i = 0; i < nchannels; i++)
+    {
+        if(x->f_signals[i])
+        {
+            Signal<t_sample>::add(n, in + ulong(i) * n, x->f_signals[i]);
+        }
+    }
+    return (w+5);
+}
+
+//! The dsp method of hoa.out~ when Pd supports the multichannel signals, it spreads the channels of the input over the outlets of a multichannel hoa.process~ or adds a single channel to its outlet.
+static void hoa_out_tilde_dsp_multi(t_hoa_out_tilde *x, t_signal **sp)
+{
+    if(x->f_nchannels && x->f_signals)
+    {
+        dsp_add(hoa_out_tilde_perform_multi, 4, x, sp[0]->s_vec, t_int(sp[0]->s_n), t_int(sp[0]->s_nchans));
+    }
+    else if(x->f_signal)
+    {
+        dsp_add(hoa_out_tilde_perform_single, 3, x, sp[0]->s_vec, t_int(sp[0]->s_n));
+    }
+}
+#endif
+
 extern "C" void setup_hoa0x2eout_tilde(void)
 {
     t_eclass* c;
+#ifdef CLASS_MULTICHANNEL
+    if(hoa_io_ismulti())
+    {
+        c = eclass_new("hoa.out~", (method)hoa_out_tilde_new, (method)eobj_free, (short)sizeof(t_hoa_out_tilde), CLASS_MULTICHANNEL, A_GIMME, 0);
+        CLASS_MAINSIGNALIN((t_class *)c, t_hoa_out_tilde, f_float);
+        class_addmethod((t_class *)c, (t_method)hoa_out_tilde_dsp_multi, gensym("dsp"), A_CANT, 0);
+        eclass_register(CLASS_OBJ, c);
+        hoa_outtilde_class = c;
+        return;
+    }
+#endif
     c = eclass_new("hoa.out~", (method)hoa_out_tilde_new, (method)eobj_dspfree, (short)sizeof(t_hoa_out_tilde), 0, A_GIMME, 0);
 
-    
     eclass_dspinit(c);
     eclass_addmethod(c, (method)hoa_out_tilde_dsp, "dsp", A_CANT, 0);
 
     eclass_register(CLASS_OBJ, c);
     hoa_outtilde_class = c;
-
 }
 
 static void *hoa_intilde_new(t_symbol *s, int argc, t_atom *argv)
@@ -215,9 +276,14 @@ static void *hoa_intilde_new(t_symbol *s, int argc, t_atom *argv)
     x = (t_hoa_in_tilde *)eobj_new(hoa_intilde_class);
     if(x)
     {
-        eobj_dspsetup(x, 0, 1);
-        x->f_extra = 0;
-        x->f_signal = NULL;
+        if(hoa_io_ismulti())
+            outlet_new((t_object *)x, &s_signal);
+        else
+            eobj_dspsetup(x, 0, 1);
+        x->f_extra      = 0;
+        x->f_signal     = NULL;
+        x->f_signals    = NULL;
+        x->f_nchannels  = 0;
         if(argc > 1 && argv && atom_gettype(argv) == A_SYM && atom_gettype(argv+1) == A_FLOAT && atom_getsym(argv) == gensym("extra") && atom_getfloat(argv+1) > 0)
         {
             x->f_extra = atom_getfloat(argv+1);
@@ -252,18 +318,53 @@ static void hoa_intilde_dsp(t_hoa_in_tilde *x, t_object *dsp, short *count, doub
         object_method(dsp, gensym("dsp_add"), x, (method)hoa_intilde_perform_zero, 0, NULL);
 }
 
+#ifdef CLASS_MULTICHANNEL
+static t_int* hoa_intilde_perform_multi(t_int* w)
+{
+    t_hoa_in_tilde* x   = (t_hoa_in_tilde *)(w[1]);
+    t_sample* out       = (t_sample *)(w[2]);
+    const size_t n      = size_t(w[3]);
+    const int nchannels = int(w[4]);
+    for(int i = 0; i < nchannels; i++)
+    {
+        t_sample const* in = x->f_nchannels ? x->f_signals[i] : x->f_signal;
+        if(in)
+            memcpy(out + size_t(i) * n, in, n * sizeof(t_sample));
+        else
+            memset(out + size_t(i) * n, 0, n * sizeof(t_sample));
+    }
+    return (w+5);
+}
+
+//! The dsp method of hoa.in~ when Pd supports the multichannel signals, it outputs all the channels of a multichannel hoa.process~ in one signal or the single channel of its inlet.
+static void hoa_intilde_dsp_multi(t_hoa_in_tilde *x, t_signal **sp)
+{
+    const int nchannels = (x->f_nchannels && x->f_signals) ? x->f_nchannels : 1;
+    hoa_signal_setmultiout()(&sp[0], nchannels);
+    dsp_add(hoa_intilde_perform_multi, 4, x, sp[0]->s_vec, t_int(sp[0]->s_n), t_int(nchannels));
+}
+#endif
+
 extern "C" void setup_hoa0x2ein_tilde(void)
 {
     t_eclass* c;
+#ifdef CLASS_MULTICHANNEL
+    if(hoa_io_ismulti())
+    {
+        c = eclass_new("hoa.in~", (method)hoa_intilde_new, (method)eobj_free, (short)sizeof(t_hoa_in_tilde), CLASS_NOINLET | CLASS_MULTICHANNEL, A_GIMME, 0);
+        class_addmethod((t_class *)c, (t_method)hoa_intilde_dsp_multi, gensym("dsp"), A_CANT, 0);
+        eclass_register(CLASS_OBJ, c);
+        hoa_intilde_class = c;
+        return;
+    }
+#endif
     c = eclass_new("hoa.in~", (method)hoa_intilde_new, (method)eobj_dspfree, (short)sizeof(t_hoa_in_tilde), CLASS_NOINLET, A_GIMME, 0);
 
-    
     eclass_dspinit(c);
     eclass_addmethod(c, (method)hoa_intilde_dsp, "dsp", A_CANT, 0);
 
     eclass_register(CLASS_OBJ, c);
     hoa_intilde_class = c;
-
 }
 
 static void *hoa_thisprocess_new(t_symbol *s, int argc, t_atom *argv)
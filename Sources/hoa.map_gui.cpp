@@ -18,7 +18,8 @@ using namespace hoa;
 typedef enum _BindingMapMsgFlag {
 	BMAP_REDRAW		= 0x01,
 	BMAP_NOTIFY		= 0x02,
-	BMAP_OUTPUT		= 0x04
+	BMAP_OUTPUT		= 0x04,
+	BMAP_FLUSH		= 0x08
 } BindingMapMsgFlag;
 
 typedef struct _linkmap t_linkmap;
@@ -28,6 +29,607 @@ static inline double hoa_pd_distance(double x1, double y1, double x2, double y2,
     return sqrt((x1-x2) * (x1-x2) + (y1-y2) * (y1-y2) + (z1-z2) * (z1-z2));
 }
 
+//! A uniform grid over the coordinates of a view plane, each cell keeps the slots that lie in it.
+/** The bounds are set when the grid is built, the slots that move out of them are kept in the cells of the border so the queries stay exact.
+ */
+typedef struct _hoa_map_grid
+{
+    double                  f_left;
+    double                  f_bottom;
+    double                  f_scale_x;
+    double                  f_scale_y;
+    long                    f_size;
+    vector< vector<ulong> > f_cells;
+    vector<ulong>           f_cell;
+} t_hoa_map_grid;
+
+static inline long hoa_map_grid_column(t_hoa_map_grid const* grid, const double x)
+{
+    return pd_clip_minmax(long((x - grid->f_left) * grid->f_scale_x), 0, grid->f_size - 1);
+}
+
+static inline long hoa_map_grid_row(t_hoa_map_grid const* grid, const double y)
+{
+    return pd_clip_minmax(long((y - grid->f_bottom) * grid->f_scale_y), 0, grid->f_size - 1);
+}
+
+static void hoa_map_grid_build(t_hoa_map_grid* grid, const double* px, const double* py, const size_t size)
+{
+    double left = 0., right = 0., bottom = 0., top = 0.;
+    if(size)
+    {
+        left = right = px[0];
+        bottom = top = py[0];
+    }
+    for(size_t i = 1; i < size; i++)
+    {
+        left = min(left, px[i]); right = max(right, px[i]);
+        bottom = min(bottom, py[i]); top = max(top, py[i]);
+    }
+
+    grid->f_size    = pd_clip_minmax(long(sqrt(double(size))), 1, 256);
+    grid->f_left    = left;
+    grid->f_bottom  = bottom;
+    grid->f_scale_x = right > left ? double(grid->f_size) / (right - left) : 0.;
+    grid->f_scale_y = top > bottom ? double(grid->f_size) / (top - bottom) : 0.;
+    grid->f_cells.assign(size_t(grid->f_size * grid->f_size), vector<ulong>());
+    grid->f_cell.resize(size);
+    for(size_t i = 0; i < size; i++)
+    {
+        grid->f_cell[i] = ulong(hoa_map_grid_row(grid, py[i]) * grid->f_size + hoa_map_grid_column(grid, px[i]));
+        grid->f_cells[grid->f_cell[i]].push_back(ulong(i));
+    }
+}
+
+static void hoa_map_grid_move(t_hoa_map_grid* grid, const ulong slot, const double x, const double y)
+{
+    const ulong cell = ulong(hoa_map_grid_row(grid, y) * grid->f_size + hoa_map_grid_column(grid, x));
+    if(cell != grid->f_cell[slot])
+    {
+        vector<ulong>& previous = grid->f_cells[grid->f_cell[slot]];
+        previous.erase(find(previous.begin(), previous.end(), slot));
+        grid->f_cells[cell].push_back(slot);
+        grid->f_cell[slot] = cell;
+    }
+}
+
+//! Returns the slot nearest to a point within a distance or -1, the highest slot wins the ties.
+static long hoa_map_grid_nearest(t_hoa_map_grid const* grid, const double* px, const double* py, const double x, const double y, double distance)
+{
+    long nearest = -1;
+    const long c1 = hoa_map_grid_column(grid, x - distance), c2 = hoa_map_grid_column(grid, x + distance);
+    const long r1 = hoa_map_grid_row(grid, y - distance), r2 = hoa_map_grid_row(grid, y + distance);
+    for(long r = r1; r <= r2; r++)
+    {
+        for(long c = c1; c <= c2; c++)
+        {
+            vector<ulong> const& cell = grid->f_cells[size_t(r * grid->f_size + c)];
+            for(size_t i = 0; i < cell.size(); i++)
+            {
+                const double test = hoa_pd_distance(px[cell[i]], py[cell[i]], x, y);
+                if(test < distance || (test == distance && long(cell[i]) > nearest))
+                {
+                    distance = test;
+                    nearest  = long(cell[i]);
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+//! Appends the slots that lie strictly inside a rectangle, the corners can be given in any order.
+static void hoa_map_grid_inside(t_hoa_map_grid const* grid, const double* px, const double* py, double x1, double y1, double x2, double y2, vector<ulong>& slots)
+{
+    if(x1 > x2)
+        swap(x1, x2);
+    if(y1 > y2)
+        swap(y1, y2);
+    const long c1 = hoa_map_grid_column(grid, x1), c2 = hoa_map_grid_column(grid, x2);
+    const long r1 = hoa_map_grid_row(grid, y1), r2 = hoa_map_grid_row(grid, y2);
+    for(long r = r1; r <= r2; r++)
+    {
+        for(long c = c1; c <= c2; c++)
+        {
+            vector<ulong> const& cell = grid->f_cells[size_t(r * grid->f_size + c)];
+            for(size_t i = 0; i < cell.size(); i++)
+            {
+                if(px[cell[i]] > x1 && px[cell[i]] < x2 && py[cell[i]] > y1 && py[cell[i]] < y2)
+                {
+                    slots.push_back(cell[i]);
+                }
+            }
+        }
+    }
+}
+
+//! A dense copy of the scene of a map, the traversals iterate over it instead of the maps of the manager.
+/** The sources and the groups are stored in slots sorted by index, their coordinates as structures of arrays. The tables give the slot of an index or -1. The members of the groups and the groups of the sources are lists of slots, the lists of the slot i are between the offsets i and i + 1. The grids index the slots in the xy, xz and yz planes. The store is rebuilt from the manager when it is stale, a source that only moved is refreshed in place. The maps bound to the same name share one store, so an edit is read once whatever the number of views, and each change of the scene gives the store a new version. The versions are unique among all the stores, a view compares its last drawn version to know if its layers are stale. The last arrays are the work space of the transformations of the groups.
+ */
+typedef struct _hoa_map_store
+{
+    bool                    f_stale;
+    ulong                   f_version;
+    ulong                   f_references;
+
+    vector<Source*>         f_sources;
+    vector<ulong>           f_sindices;
+    vector<long>            f_sslots;
+    vector<double>          f_sx, f_sy, f_sz;
+    vector<double>          f_sr, f_sa, f_se;
+    vector<char>            f_smute;
+    vector<ulong>           f_sgroups_offsets;
+    vector<ulong>           f_sgroups;
+    t_hoa_map_grid          f_sgrids[3];
+
+    vector<Source::Group*>  f_groups;
+    vector<ulong>           f_gindices;
+    vector<long>            f_gslots;
+    vector<double>          f_gx, f_gy, f_gz;
+    vector<double>          f_gr, f_ga, f_ge;
+    vector<char>            f_gmute;
+    vector<ulong>           f_gsources_offsets;
+    vector<ulong>           f_gsources;
+    t_hoa_map_grid          f_ggrids[3];
+
+    vector<double>          f_tx, f_ty, f_tz;
+    vector<ulong>           f_tgroups;
+} t_hoa_map_store;
+
+static inline long hoa_map_store_slot(vector<long> const& slots, const ulong index)
+{
+    return index < slots.size() ? slots[index] : -1;
+}
+
+//! Returns the first index that has no slot.
+static inline ulong hoa_map_store_free_index(vector<long> const& slots)
+{
+    ulong index = 1;
+    while(index < slots.size() && slots[index] >= 0)
+    {
+        index++;
+    }
+    return index;
+}
+
+static ulong hoa_map_store_versions = 0;
+
+static t_hoa_map_store* hoa_map_store_new()
+{
+    t_hoa_map_store* st = new t_hoa_map_store();
+    st->f_stale         = true;
+    st->f_version       = ++hoa_map_store_versions;
+    st->f_references    = 0;
+    return st;
+}
+
+static void hoa_map_store_release(t_hoa_map_store* st)
+{
+    if(st && --st->f_references == 0)
+    {
+        delete st;
+    }
+}
+
+//! The indices of the sources and the groups that changed since the last output of a map, kept for the delta output. They survive the rebuilds of the store.
+typedef struct _hoa_map_changes
+{
+    bool                    f_all;
+    vector<char>            f_sflags;
+    vector<ulong>           f_sources;
+    vector<char>            f_gflags;
+    vector<ulong>           f_groups;
+} t_hoa_map_changes;
+
+//! Marks an index as changed since the last output, the indices above HOA_MAP_MAXINDEX are ignored.
+static inline void hoa_map_changes_add(vector<char>& flags, vector<ulong>& changed, const ulong index)
+{
+    if(index > HOA_MAP_MAXINDEX)
+        return;
+    if(index >= flags.size())
+        flags.resize(index + 1, 0);
+    if(!flags[index])
+    {
+        flags[index] = 1;
+        changed.push_back(index);
+    }
+}
+
+static void hoa_map_changes_clear(t_hoa_map_changes* ch)
+{
+    for(size_t i = 0; i < ch->f_sources.size(); i++)
+        ch->f_sflags[ch->f_sources[i]] = 0;
+    for(size_t i = 0; i < ch->f_groups.size(); i++)
+        ch->f_gflags[ch->f_groups[i]] = 0;
+    ch->f_sources.clear();
+    ch->f_groups.clear();
+    ch->f_all = false;
+}
+
+static inline bool hoa_map_changes_empty(t_hoa_map_changes const* ch)
+{
+    return !ch->f_all && ch->f_sources.empty() && ch->f_groups.empty();
+}
+
+static inline void hoa_map_store_read_source(t_hoa_map_store* st, const size_t i)
+{
+    Source* src = st->f_sources[i];
+    st->f_sx[i] = src->getAbscissa();
+    st->f_sy[i] = src->getOrdinate();
+    st->f_sz[i] = src->getHeight();
+    st->f_sr[i] = src->getRadius();
+    st->f_sa[i] = src->getAzimuth();
+    st->f_se[i] = src->getElevation();
+    st->f_smute[i] = char(src->getMute());
+}
+
+static inline void hoa_map_store_read_group(t_hoa_map_store* st, const size_t i)
+{
+    Source::Group* grp = st->f_groups[i];
+    st->f_gx[i] = grp->getAbscissa();
+    st->f_gy[i] = grp->getOrdinate();
+    st->f_gz[i] = grp->getHeight();
+    st->f_gr[i] = grp->getRadius();
+    st->f_ga[i] = grp->getAzimuth();
+    st->f_ge[i] = grp->getElevation();
+    st->f_gmute[i] = char(grp->getMute());
+}
+
+static void hoa_map_store_rebuild(t_hoa_map_store* st, Source::Manager* manager)
+{
+    const size_t nsources = size_t(manager->getNumberOfSources());
+    const size_t ngroups  = size_t(manager->getNumberOfGroups());
+
+    st->f_sources.clear(); st->f_sindices.clear();
+    st->f_sources.reserve(nsources); st->f_sindices.reserve(nsources);
+    for(Source::source_iterator it = manager->getFirstSource() ; it != manager->getLastSource() ; it ++)
+    {
+        st->f_sources.push_back(it->second);
+        st->f_sindices.push_back(it->first);
+    }
+    st->f_sx.resize(nsources); st->f_sy.resize(nsources); st->f_sz.resize(nsources);
+    st->f_sr.resize(nsources); st->f_sa.resize(nsources); st->f_se.resize(nsources);
+    st->f_smute.resize(nsources);
+    st->f_sslots.assign(nsources ? st->f_sindices.back() + 1 : 0, -1);
+    for(size_t i = 0; i < nsources; i++)
+    {
+        hoa_map_store_read_source(st, i);
+        st->f_sslots[st->f_sindices[i]] = long(i);
+    }
+
+    st->f_groups.clear(); st->f_gindices.clear();
+    st->f_groups.reserve(ngroups); st->f_gindices.reserve(ngroups);
+    for(Source::group_iterator it = manager->getFirstGroup() ; it != manager->getLastGroup() ; it ++)
+    {
+        st->f_groups.push_back(it->second);
+        st->f_gindices.push_back(it->first);
+    }
+    st->f_gx.resize(ngroups); st->f_gy.resize(ngroups); st->f_gz.resize(ngroups);
+    st->f_gr.resize(ngroups); st->f_ga.resize(ngroups); st->f_ge.resize(ngroups);
+    st->f_gmute.resize(ngroups);
+    st->f_gslots.assign(ngroups ? st->f_gindices.back() + 1 : 0, -1);
+    for(size_t i = 0; i < ngroups; i++)
+    {
+        hoa_map_store_read_group(st, i);
+        st->f_gslots[st->f_gindices[i]] = long(i);
+    }
+
+    st->f_gsources_offsets.assign(1, 0);
+    st->f_gsources.clear();
+    for(size_t i = 0; i < ngroups; i++)
+    {
+        map<ulong, Source*>& sourcesOfGroup = st->f_groups[i]->getSources();
+        for(Source::source_iterator it = sourcesOfGroup.begin() ; it != sourcesOfGroup.end() ; it ++)
+        {
+            const long slot = hoa_map_store_slot(st->f_sslots, it->first);
+            if(slot >= 0)
+            {
+                st->f_gsources.push_back(ulong(slot));
+            }
+        }
+        st->f_gsources_offsets.push_back(st->f_gsources.size());
+    }
+
+    st->f_sgroups_offsets.assign(1, 0);
+    st->f_sgroups.clear();
+    for(size_t i = 0; i < nsources; i++)
+    {
+        map<ulong, Source::Group*>& groupsOfSource = st->f_sources[i]->getGroups();
+        for(Source::group_iterator it = groupsOfSource.begin() ; it != groupsOfSource.end() ; it ++)
+        {
+            const long slot = hoa_map_store_slot(st->f_gslots, it->first);
+            if(slot >= 0)
+            {
+                st->f_sgroups.push_back(ulong(slot));
+            }
+        }
+        st->f_sgroups_offsets.push_back(st->f_sgroups.size());
+    }
+
+    hoa_map_grid_build(st->f_sgrids,   st->f_sx.data(), st->f_sy.data(), nsources);
+    hoa_map_grid_build(st->f_sgrids+1, st->f_sx.data(), st->f_sz.data(), nsources);
+    hoa_map_grid_build(st->f_sgrids+2, st->f_sy.data(), st->f_sz.data(), nsources);
+    hoa_map_grid_build(st->f_ggrids,   st->f_gx.data(), st->f_gy.data(), ngroups);
+    hoa_map_grid_build(st->f_ggrids+1, st->f_gx.data(), st->f_gz.data(), ngroups);
+    hoa_map_grid_build(st->f_ggrids+2, st->f_gy.data(), st->f_gz.data(), ngroups);
+    st->f_stale = false;
+}
+
+//! Reads again a source that moved or changed its mute state, and the groups it belongs to. The structure of the scene must not have changed. Returns the slot of the source or -1 if the store must be rebuilt.
+static long hoa_map_store_refresh(t_hoa_map_store* st, Source* src)
+{
+    st->f_version = ++hoa_map_store_versions;
+    if(st->f_stale)
+        return -1;
+
+    const long slot = hoa_map_store_slot(st->f_sslots, src->getIndex());
+    if(slot < 0 || st->f_sources[slot] != src)
+    {
+        st->f_stale = true;
+        return -1;
+    }
+
+    hoa_map_store_read_source(st, size_t(slot));
+    hoa_map_grid_move(st->f_sgrids,   ulong(slot), st->f_sx[slot], st->f_sy[slot]);
+    hoa_map_grid_move(st->f_sgrids+1, ulong(slot), st->f_sx[slot], st->f_sz[slot]);
+    hoa_map_grid_move(st->f_sgrids+2, ulong(slot), st->f_sy[slot], st->f_sz[slot]);
+    for(ulong i = st->f_sgroups_offsets[slot]; i < st->f_sgroups_offsets[slot+1]; i++)
+    {
+        const ulong grp = st->f_sgroups[i];
+        hoa_map_store_read_group(st, grp);
+        hoa_map_grid_move(st->f_ggrids,   grp, st->f_gx[grp], st->f_gy[grp]);
+        hoa_map_grid_move(st->f_ggrids+1, grp, st->f_gx[grp], st->f_gz[grp]);
+        hoa_map_grid_move(st->f_ggrids+2, grp, st->f_gy[grp], st->f_gz[grp]);
+    }
+    return slot;
+}
+
+//! Reads again the sources of a group that moved and the groups they belong to, each group once. The structure of the scene must not have changed. Returns false if the store must be rebuilt.
+static bool hoa_map_store_refresh_group(t_hoa_map_store* st, const long slot)
+{
+    st->f_version = ++hoa_map_store_versions;
+    if(st->f_stale || slot < 0)
+        return false;
+
+    st->f_tgroups.clear();
+    for(ulong i = st->f_gsources_offsets[slot]; i < st->f_gsources_offsets[slot+1]; i++)
+    {
+        const ulong src = st->f_gsources[i];
+        hoa_map_store_read_source(st, src);
+        hoa_map_grid_move(st->f_sgrids,   src, st->f_sx[src], st->f_sy[src]);
+        hoa_map_grid_move(st->f_sgrids+1, src, st->f_sx[src], st->f_sz[src]);
+        hoa_map_grid_move(st->f_sgrids+2, src, st->f_sy[src], st->f_sz[src]);
+        st->f_tgroups.insert(st->f_tgroups.end(), st->f_sgroups.begin() + st->f_sgroups_offsets[src], st->f_sgroups.begin() + st->f_sgroups_offsets[src+1]);
+    }
+    sort(st->f_tgroups.begin(), st->f_tgroups.end());
+    st->f_tgroups.erase(unique(st->f_tgroups.begin(), st->f_tgroups.end()), st->f_tgroups.end());
+    for(size_t i = 0; i < st->f_tgroups.size(); i++)
+    {
+        const ulong grp = st->f_tgroups[i];
+        hoa_map_store_read_group(st, grp);
+        hoa_map_grid_move(st->f_ggrids,   grp, st->f_gx[grp], st->f_gy[grp]);
+        hoa_map_grid_move(st->f_ggrids+1, grp, st->f_gx[grp], st->f_gz[grp]);
+        hoa_map_grid_move(st->f_ggrids+2, grp, st->f_gy[grp], st->f_gz[grp]);
+    }
+    return true;
+}
+
+//! A scene read from the atoms of a preset, the sources and the groups are stored in the order of the preset as structures of arrays.
+/** The members of the group i are the indices of sources between the offsets i and i + 1. The atoms are kept to recognise the preset when it is given again, so a preset is parsed only once.
+ */
+typedef struct _hoa_map_scene
+{
+    vector<t_atom>          f_atoms;
+
+    vector<ulong>           f_sindices;
+    vector<float>           f_sx, f_sy, f_sz;
+    vector<char>            f_smute;
+    vector<char>            f_scolored;
+    vector<float>           f_scolors;
+    vector<t_symbol*>       f_sdescriptions;
+
+    vector<ulong>           f_gindices;
+    vector<ulong>           f_gsources_offsets;
+    vector<ulong>           f_gsources;
+    vector<char>            f_gcolored;
+    vector<float>           f_gcolors;
+    vector<t_symbol*>       f_gdescriptions;
+} t_hoa_map_scene;
+
+//! The state of the interpolation between two presets, the coordinates of the second preset are gathered in the order of the first one.
+/** The sources of the first preset that don't exist in the second one keep their coordinates. The slots of the second preset by index are kept between the pairings, only their used entries are reset. The version is the one of the store after the last step, if the scene didn't change since, the next step only moves the sources whose coordinates differ from the last ones applied.
+ */
+typedef struct _hoa_map_interp
+{
+    t_hoa_map_scene         f_from;
+    t_hoa_map_scene         f_to;
+    vector<float>           f_tx, f_ty, f_tz;
+    vector<float>           f_x, f_y, f_z;
+    vector<float>           f_lx, f_ly, f_lz;
+    vector<Source*>         f_sources;
+    vector<long>            f_slots;
+    ulong                   f_version;
+} t_hoa_map_interp;
+
+#define HOA_MAP_TRAJECTORY_QUANTUM  0.0001
+#define HOA_MAP_TRAJECTORY_KEYS     32
+#define HOA_MAP_TRAJECTORY_TICK     5.
+#define HOA_MAP_TRAJECTORY_VERSION  1
+
+//! A point of a trajectory, the time is in microseconds and the coordinates in quanta.
+typedef struct _hoa_map_point
+{
+    long long               f_time;
+    long long               f_x, f_y, f_z;
+    char                    f_mute;
+} t_hoa_map_point;
+
+//! A point from which a stream can be decoded, kept every HOA_MAP_TRAJECTORY_KEYS points.
+typedef struct _hoa_map_keyframe
+{
+    t_hoa_map_point         f_point;
+    size_t                  f_offset;
+} t_hoa_map_keyframe;
+
+//! The trajectory of a source, a stream of points encoded as the differences with the previous one.
+/** Each point is a varint of the time difference shifted left with the mute state in the low bit, then the zigzag varints of the differences of the coordinates. The cursor keeps the two points around the time of the playback.
+ */
+typedef struct _hoa_map_track
+{
+    ulong                       f_index;
+    vector<unsigned char>       f_data;
+    vector<t_hoa_map_keyframe>  f_keys;
+    ulong                       f_size;
+    t_hoa_map_point             f_last;
+
+    t_hoa_map_point             f_a;
+    t_hoa_map_point             f_b;
+    bool                        f_has_b;
+    ulong                       f_number;
+    size_t                      f_offset;
+} t_hoa_map_track;
+
+//! The recorder and the player of the trajectories of the sources of a map.
+typedef struct _hoa_map_trajectory
+{
+    vector<t_hoa_map_track>     f_tracks;
+    vector<long>                f_slots;
+    bool                        f_recording;
+    bool                        f_playing;
+    bool                        f_loop;
+    double                      f_speed;
+    double                      f_start;
+    double                      f_position;
+    double                      f_duration;
+    double                      f_last;
+    t_clock*                    f_clock;
+} t_hoa_map_trajectory;
+
+static inline void hoa_map_varint_put(vector<unsigned char>& data, unsigned long long value)
+{
+    while(value >= 0x80)
+    {
+        data.push_back((unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back((unsigned char)value);
+}
+
+//! Reads a varint, returns false if it is truncated or longer than the 10 bytes of a 64 bits value.
+static inline bool hoa_map_varint_get(vector<unsigned char> const& data, size_t& offset, unsigned long long& value)
+{
+    value = 0;
+    for(int shift = 0; shift < 70 && offset < data.size(); shift += 7)
+    {
+        const unsigned char byte = data[offset++];
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static inline unsigned long long hoa_map_zigzag(const long long value)
+{
+    return value < 0 ? ((unsigned long long)(-(value + 1)) << 1) | 1 : (unsigned long long)value << 1;
+}
+
+static inline long long hoa_map_unzigzag(const unsigned long long value)
+{
+    return value & 1 ? -(long long)(value >> 1) - 1 : (long long)(value >> 1);
+}
+
+//! Appends a point to a track, the first point and the keyframes are relative to a zero point.
+static void hoa_map_track_append(t_hoa_map_track* track, t_hoa_map_point const& point)
+{
+    if(track->f_size % HOA_MAP_TRAJECTORY_KEYS == 0)
+    {
+        t_hoa_map_keyframe key = {point, 0};
+        track->f_keys.push_back(key);
+        track->f_last = point;
+        track->f_last.f_time = 0; track->f_last.f_x = track->f_last.f_y = track->f_last.f_z = 0;
+    }
+    hoa_map_varint_put(track->f_data, (unsigned long long)(point.f_time - track->f_last.f_time) << 1 | (point.f_mute ? 1 : 0));
+    hoa_map_varint_put(track->f_data, hoa_map_zigzag(point.f_x - track->f_last.f_x));
+    hoa_map_varint_put(track->f_data, hoa_map_zigzag(point.f_y - track->f_last.f_y));
+    hoa_map_varint_put(track->f_data, hoa_map_zigzag(point.f_z - track->f_last.f_z));
+    if(track->f_size % HOA_MAP_TRAJECTORY_KEYS == 0)
+        track->f_keys.back().f_offset = track->f_data.size();
+    track->f_last = point;
+    track->f_size++;
+}
+
+//! Decodes the point at the offset of a track in the point b, relative to a base point. Returns false if the stream is invalid.
+static bool hoa_map_track_decode(t_hoa_map_track* track, t_hoa_map_point const& base)
+{
+    unsigned long long head, x, y, z;
+    if(!hoa_map_varint_get(track->f_data, track->f_offset, head) || !hoa_map_varint_get(track->f_data, track->f_offset, x)
+       || !hoa_map_varint_get(track->f_data, track->f_offset, y) || !hoa_map_varint_get(track->f_data, track->f_offset, z))
+        return false;
+    track->f_b.f_time = base.f_time + (long long)(head >> 1);
+    track->f_b.f_mute = char(head & 1);
+    track->f_b.f_x = base.f_x + hoa_map_unzigzag(x);
+    track->f_b.f_y = base.f_y + hoa_map_unzigzag(y);
+    track->f_b.f_z = base.f_z + hoa_map_unzigzag(z);
+    return true;
+}
+
+//! Decodes the point that follows the point b of the cursor, the keyframes restart the differences.
+static void hoa_map_track_next(t_hoa_map_track* track)
+{
+    track->f_has_b = track->f_offset < track->f_data.size();
+    if(!track->f_has_b)
+        return;
+
+    const ulong number = ++track->f_number;
+    t_hoa_map_point base = track->f_b;
+    if(number % HOA_MAP_TRAJECTORY_KEYS == 0)
+    {
+        base.f_time = 0; base.f_x = base.f_y = base.f_z = 0;
+    }
+    track->f_has_b = hoa_map_track_decode(track, base);
+}
+
+//! Moves the cursor of a track forward to a time.
+static void hoa_map_track_advance(t_hoa_map_track* track, const long long time)
+{
+    while(track->f_has_b && track->f_b.f_time <= time)
+    {
+        track->f_a = track->f_b;
+        hoa_map_track_next(track);
+    }
+}
+
+//! Moves the cursor of a track so the point a is the last one before a time, from the nearest keyframe.
+static void hoa_map_track_seek(t_hoa_map_track* track, const long long time)
+{
+    size_t key = 0;
+    size_t low = 0, high = track->f_keys.size();
+    while(low < high)
+    {
+        const size_t mid = (low + high) / 2;
+        if(track->f_keys[mid].f_point.f_time <= time)
+        {
+            key = mid;
+            low = mid + 1;
+        }
+        else
+            high = mid;
+    }
+    if(track->f_keys.empty())
+    {
+        track->f_has_b = false;
+        return;
+    }
+    track->f_number = ulong(key * HOA_MAP_TRAJECTORY_KEYS);
+    track->f_a      = track->f_keys[key].f_point;
+    track->f_b      = track->f_a;
+    track->f_offset = track->f_keys[key].f_offset;
+    hoa_map_track_next(track);
+    hoa_map_track_advance(track, time);
+}
+
+
 typedef struct  _hoa_map
 {
 	t_ebox           j_box;
@@ -39,6 +641,12 @@ typedef struct  _hoa_map
 
 	Source::Manager* f_manager;
 	Source::Manager* f_self_manager;
+    t_hoa_map_store* f_store;
+    t_hoa_map_changes* f_changes;
+    ulong            f_drawn_version;
+    ulong            f_output_version;
+    t_hoa_map_interp* f_interp;
+    t_hoa_map_trajectory* f_trajectory;
 
 	Source*          f_selected_source;
 	Source::Group*   f_selected_group;
@@ -64,6 +672,14 @@ typedef struct  _hoa_map
 	t_symbol*	     f_binding_name;
 	t_linkmap*	     f_listmap;
 	int			     f_output_enabled;
+
+    HoaMapSnapshot*  f_snapshot;
+
+    long             f_delta;
+    long             f_packed;
+    long             f_compact;
+    int              f_delta_wait;
+    t_clock*         f_delta_clock;
 } t_hoa_map;
 
 typedef struct _linkmap
@@ -95,8 +711,12 @@ t_pd_err  hoa_map_view(t_hoa_map *x, t_object *attr, int argc, t_atom *argv);
 t_pd_err  hoa_map_notify(t_hoa_map *x, t_symbol *s, t_symbol *msg, void *sender, void *data);
 
 /*Sorties*/
+void      hoa_map_bang(t_hoa_map *x);
 void      hoa_map_infos(t_hoa_map *x);
 void      hoa_map_output(t_hoa_map *x);
+void      hoa_map_output_all(t_hoa_map *x);
+void      hoa_map_output_tick(t_hoa_map *x);
+t_pd_err  hoa_map_delta_set(t_hoa_map *x, void *attr, int argc, t_atom *argv);
 
 /*Paint*/
 void      hoa_map_paint(t_hoa_map *x, t_object *view);
@@ -110,6 +730,10 @@ void      hoa_map_drawRectSelection(t_hoa_map *x,  t_object *view, t_rect *rect)
 t_symbol* hoa_map_stringFormat(const char *s);
 void      hoa_map_preset(t_hoa_map *x, t_binbuf *b);
 void      hoa_map_sourcesPreset(t_hoa_map *x, t_symbol *s, int ac, t_atom *av);
+void      hoa_map_read(t_hoa_map *x, t_symbol *s);
+void      hoa_map_write(t_hoa_map *x, t_symbol *s);
+void      hoa_map_trajectory(t_hoa_map *x, t_symbol *s, int ac, t_atom *av);
+void      hoa_map_trajectory_tick(t_hoa_map *x);
 void      hoa_map_mouseup(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifiers);
 void      hoa_map_mousedown(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifiers);
 void      hoa_map_mousedrag(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifiers);
@@ -123,62 +747,391 @@ void      hoa_map_isElementSelected(t_hoa_map *x, t_pt pt);
 void      hoa_map_sendBindedMapUpdate(t_hoa_map *x, long flags);
 t_pd_err  hoa_map_bindnameSet(t_hoa_map *x, void *attr, int argc, t_atom *argv);
 void      hoa_map_linkmapAddWithBindingName(t_hoa_map *x, t_symbol* binding_name);
-void      hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name);
+void      hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name, bool freed = false);
 void      hoa_map_getDrawParams(t_hoa_map *x, t_object *patcherview, t_edrawparams *params);
 
 static t_symbol* hoa_sym_sources_preset;
 static t_symbol* hoa_sym_view_xy = gensym("xy");
 static t_symbol* hoa_sym_view_xz = gensym("xz");
 static t_symbol* hoa_sym_view_yz = gensym("yz");
-
-extern "C" void setup_hoa0x2emap(void)
+static t_symbol* hoa_sym_scene   = gensym("scene");
+static t_symbol* hoa_sym_trajectory = gensym("trajectory");
+static t_symbol* hoa_sym_play    = gensym("play");
+static t_symbol* hoa_sym_seek    = gensym("seek");
+static t_symbol* hoa_sym_loop    = gensym("loop");
+static t_symbol* hoa_sym_speed   = gensym("speed");
+static t_symbol* hoa_sym_end     = gensym("end");
+
+//! Gives the arrays of the coordinates displayed by a view, the horizontal then the vertical axis of the screen.
+static inline void hoa_map_store_plane(t_symbol* view, vector<double> const& x, vector<double> const& y, vector<double> const& z, const double*& px, const double*& py)
 {
-	t_eclass *c;
-
-	c = eclass_new("hoa.map", (method)hoa_map_new, (method)hoa_map_free, sizeof(t_hoa_map), 0L, A_GIMME, 0);
-    class_addcreator((t_newmethod)hoa_map_new, gensym("hoa.2d.map"), A_GIMME, 0);
-    class_addcreator((t_newmethod)hoa_map_new, gensym("hoa.3d.map"), A_GIMME, 0);
+    if(view == hoa_sym_view_xy)
+    {
+        px = x.data(); py = y.data();
+    }
+    else if(view == hoa_sym_view_xz)
+    {
+        px = x.data(); py = z.data();
+    }
+    else
+    {
+        px = y.data(); py = z.data();
+    }
+}
 
-    eclass_guiinit(c, 0);
+//! Returns the grid of a view, in the same order as the planes.
+static inline int hoa_map_store_grid(t_symbol* view)
+{
+    return view == hoa_sym_view_xy ? 0 : (view == hoa_sym_view_xz ? 1 : 2);
+}
 
-	eclass_addmethod(c, (method) hoa_map_paint,         "paint",          A_CANT,  0);
-	eclass_addmethod(c, (method) hoa_map_getDrawParams, "getDrawParams",  A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_oksize,        "oksize",         A_CANT,  0);
-	eclass_addmethod(c, (method) hoa_map_notify,        "notify",         A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_output,        "bang",           A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_infos,         "getinfo",        A_GIMME, 0);
+//! Returns the dense store of the map, rebuilt if the scene changed since the last traversal.
+static t_hoa_map_store* hoa_map_store(t_hoa_map *x)
+{
+    if(x->f_store->f_stale)
+    {
+        hoa_map_store_rebuild(x->f_store, x->f_manager);
+    }
+    return x->f_store;
+}
 
-    eclass_addmethod(c, (method) hoa_map_source,        "source",         A_GIMME, 0);
-    eclass_addmethod(c, (method) hoa_map_group,         "group",          A_GIMME, 0);
-    eclass_addmethod(c, (method) hoa_map_clearAll,      "clear",          A_GIMME, 0);
-	eclass_addmethod(c, (method) hoa_map_set,			"set",			  A_GIMME, 0);
+//! Makes the map read a store, the previous one is released.
+static void hoa_map_store_attach(t_hoa_map *x, t_hoa_map_store* st)
+{
+    st->f_references++;
+    hoa_map_store_release(x->f_store);
+    x->f_store = st;
+    x->f_store->f_stale = true;
+    x->f_store->f_version = ++hoa_map_store_versions;
+}
 
-    eclass_addmethod(c, (method) hoa_map_mousedown,     "mousedown",      A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_mousedrag,     "mousedrag",      A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_mouseup,       "mouseup",        A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_mousemove,     "mousemove",      A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_mousewheel,    "mousewheel",     A_CANT,  0);
-	eclass_addmethod(c, (method) hoa_map_popup,         "popup",          A_CANT,  0);
+//! Writes all the sources in the snapshot read by the hoa.map~ bound to the map, the sources that don't exist anymore are muted.
+static void hoa_map_publish(t_hoa_map *x)
+{
+    if(!x->f_snapshot)
+        return;
 
-    eclass_addmethod(c, (method) hoa_map_preset,        "preset",         A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_interpolate,   "interpolate",    A_CANT,  0);
-    eclass_addmethod(c, (method) hoa_map_sourcesPreset, "sources_preset",  A_GIMME, 0);
+    t_hoa_map_store* st = hoa_map_store(x);
+    HoaMapSnapshot* snapshot = x->f_snapshot;
+    for(ulong i = 1; i <= snapshot->getSize(); i++)
+    {
+        if(hoa_map_store_slot(st->f_sslots, i) < 0)
+            snapshot->remove(i);
+    }
+    for(size_t i = 0; i < st->f_sources.size(); i++)
+    {
+        snapshot->write(st->f_sindices[i], st->f_smute[i], st->f_sr[i], st->f_sa[i], st->f_se[i]);
+    }
+    snapshot->publish();
+}
 
-	CLASS_ATTR_DEFAULT              (c, "size", 0, "225 225");
+//! Writes a source in the snapshot read by the hoa.map~ bound to the map.
+static void hoa_map_publish_source(t_hoa_map *x, Source* src)
+{
+    if(x->f_snapshot)
+    {
+        x->f_snapshot->write(src->getIndex(), src->getMute(), src->getRadius(), src->getAzimuth(), src->getElevation());
+        x->f_snapshot->publish();
+    }
+}
 
-    CLASS_ATTR_RGBA					(c, "bgcolor", 0, t_hoa_map, f_color_bg);
-	CLASS_ATTR_CATEGORY				(c, "bgcolor", 0, "Color");
-	CLASS_ATTR_STYLE				(c, "bgcolor", 0, "rgba");
-	CLASS_ATTR_LABEL				(c, "bgcolor", 0, "Background Color");
-	CLASS_ATTR_DEFAULT_SAVE_PAINT	(c, "bgcolor", 0, "0.76 0.76 0.76 1.");
+static t_hoa_map_track* hoa_map_trajectory_track(t_hoa_map_trajectory* tj, const ulong index)
+{
+    long slot = hoa_map_store_slot(tj->f_slots, index);
+    if(slot < 0)
+    {
+        if(index >= tj->f_slots.size())
+            tj->f_slots.resize(index + 1, -1);
+        slot = long(tj->f_tracks.size());
+        tj->f_slots[index] = slot;
+        tj->f_tracks.push_back(t_hoa_map_track());
+        t_hoa_map_track* track = &tj->f_tracks.back();
+        track->f_index  = index;
+        track->f_size   = 0;
+        track->f_has_b  = false;
+        track->f_number = 0;
+        track->f_offset = 0;
+    }
+    return &tj->f_tracks[size_t(slot)];
+}
 
-    CLASS_ATTR_RGBA					(c, "bdcolor", 0, t_hoa_map, f_color_bd);
-	CLASS_ATTR_CATEGORY				(c, "bdcolor", 0, "Color");
-	CLASS_ATTR_STYLE                (c, "bdcolor", 0, "rgba");
-    CLASS_ATTR_LABEL				(c, "bdcolor", 0, "Border Color");
-	CLASS_ATTR_DEFAULT_SAVE_PAINT	(c, "bdcolor", 0, "0.7 0.7 0.7 1.");
+//! Appends the state of a source to its trajectory if it changed since the last point.
+static void hoa_map_trajectory_capture(t_hoa_map_trajectory* tj, Source* src)
+{
+    t_hoa_map_point point;
+    point.f_time = (long long)(clock_gettimesince(tj->f_start) * 1000.);
+    point.f_x    = (long long)floor(src->getAbscissa() / HOA_MAP_TRAJECTORY_QUANTUM + 0.5);
+    point.f_y    = (long long)floor(src->getOrdinate() / HOA_MAP_TRAJECTORY_QUANTUM + 0.5);
+    point.f_z    = (long long)floor(src->getHeight() / HOA_MAP_TRAJECTORY_QUANTUM + 0.5);
+    point.f_mute = char(src->getMute());
+
+    t_hoa_map_track* track = hoa_map_trajectory_track(tj, src->getIndex());
+    t_hoa_map_point const& last = track->f_last;
+    if(!track->f_size || last.f_x != point.f_x || last.f_y != point.f_y || last.f_z != point.f_z || last.f_mute != point.f_mute)
+    {
+        hoa_map_track_append(track, point);
+    }
+}
 
-	CLASS_ATTR_SYMBOL				(c, "view", 0, t_hoa_map, f_coord_view);
+static void hoa_map_record_map(t_hoa_map *x, Source* src)
+{
+    if(!x->f_trajectory->f_recording)
+        return;
+    if(src)
+    {
+        hoa_map_trajectory_capture(x->f_trajectory, src);
+    }
+    else
+    {
+        for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource() ; it ++)
+            hoa_map_trajectory_capture(x->f_trajectory, it->second);
+    }
+}
+
+//! Records a source that moved, or all the sources, in the trajectories of the map and of the maps bound to it that are recording.
+static void hoa_map_record(t_hoa_map *x, Source* src)
+{
+    if(x->f_listmap)
+    {
+        for(t_linkmap* temp = x->f_listmap; temp; temp = temp->next)
+            hoa_map_record_map(temp->map, src);
+    }
+    else
+    {
+        hoa_map_record_map(x, src);
+    }
+}
+
+//! Marks the store shared by the map and the maps bound to it as stale, must be called after each change of the scene.
+static void hoa_map_touch(t_hoa_map *x)
+{
+    x->f_store->f_stale = true;
+    x->f_store->f_version = ++hoa_map_store_versions;
+    if(x->f_output_enabled)
+    {
+        x->f_changes->f_all = true;
+        for(t_linkmap* temp = x->f_listmap; temp; temp = temp->next)
+        {
+            temp->map->f_changes->f_all = true;
+        }
+    }
+    hoa_map_publish(x);
+    hoa_map_record(x, NULL);
+}
+
+//! Marks a source that moved and the groups it belongs to as changed for the delta output of a map.
+static void hoa_map_change_source(t_hoa_map *x, t_hoa_map_store const* st, const long slot)
+{
+    t_hoa_map_changes* ch = x->f_changes;
+    if(slot < 0)
+    {
+        ch->f_all = true;
+        return;
+    }
+    hoa_map_changes_add(ch->f_sflags, ch->f_sources, st->f_sindices[slot]);
+    for(ulong i = st->f_sgroups_offsets[slot]; i < st->f_sgroups_offsets[slot+1]; i++)
+    {
+        hoa_map_changes_add(ch->f_gflags, ch->f_groups, st->f_gindices[st->f_sgroups[i]]);
+    }
+}
+
+//! Refreshes a source that moved in the store shared by the map and the maps bound to it.
+static void hoa_map_refresh(t_hoa_map *x, Source* src)
+{
+    const long slot = hoa_map_store_refresh(x->f_store, src);
+    if(x->f_output_enabled)
+    {
+        hoa_map_change_source(x, x->f_store, slot);
+        for(t_linkmap* temp = x->f_listmap; temp; temp = temp->next)
+        {
+            if(temp->map != x)
+                hoa_map_change_source(temp->map, x->f_store, slot);
+        }
+    }
+    hoa_map_publish_source(x, src);
+    hoa_map_record(x, src);
+}
+
+//! Refreshes the sources of a group that moved in the store of the map and of the maps bound to it, only the sources of the group and their groups are marked as changed.
+static void hoa_map_refresh_group(t_hoa_map *x, Source::Group* group)
+{
+    t_hoa_map_store* st = x->f_store;
+    const long slot = st->f_stale ? -1 : hoa_map_store_slot(st->f_gslots, group->getIndex());
+    if(slot < 0 || st->f_groups[slot] != group || st->f_gsources_offsets[slot] == st->f_gsources_offsets[slot+1])
+    {
+        hoa_map_touch(x);
+        return;
+    }
+
+    hoa_map_store_refresh_group(st, slot);
+    for(ulong i = st->f_gsources_offsets[slot]; i < st->f_gsources_offsets[slot+1]; i++)
+    {
+        const ulong src = st->f_gsources[i];
+        if(x->f_output_enabled)
+        {
+            hoa_map_change_source(x, st, long(src));
+            for(t_linkmap* temp = x->f_listmap; temp; temp = temp->next)
+            {
+                if(temp->map != x)
+                    hoa_map_change_source(temp->map, st, long(src));
+            }
+        }
+        if(x->f_snapshot)
+            x->f_snapshot->write(st->f_sindices[src], st->f_smute[src], st->f_sr[src], st->f_sa[src], st->f_se[src]);
+        hoa_map_record(x, st->f_sources[src]);
+    }
+    if(x->f_snapshot)
+        x->f_snapshot->publish();
+}
+
+//! Scales, turns and then moves the sources of a group in one pass over the coordinates of the store.
+/** The radius is an offset of the distance of each source to the center, in the plane of the view or in space, the azimuth turns the sources in the plane of the view and the deltas are added to their coordinates. Each source is written once, the store must be refreshed after with hoa_map_refresh_group.
+ */
+static void hoa_map_group_transform(t_hoa_map *x, Source::Group* group, t_symbol* view, const bool spatial, const double radius, const double azimuth, const double dx, const double dy, const double dz)
+{
+    t_hoa_map_store* st = hoa_map_store(x);
+    const long slot = hoa_map_store_slot(st->f_gslots, group->getIndex());
+    if(slot < 0)
+        return;
+
+    const ulong* members = st->f_gsources.data() + st->f_gsources_offsets[slot];
+    const size_t size = st->f_gsources_offsets[slot+1] - st->f_gsources_offsets[slot];
+    st->f_tx.resize(size); st->f_ty.resize(size); st->f_tz.resize(size);
+    double* tx = st->f_tx.data();
+    double* ty = st->f_ty.data();
+    double* tz = st->f_tz.data();
+    for(size_t i = 0; i < size; i++)
+    {
+        tx[i] = st->f_sx[members[i]];
+        ty[i] = st->f_sy[members[i]];
+        tz[i] = st->f_sz[members[i]];
+    }
+
+    double *pa, *pb;
+    if(view == hoa_sym_view_xy)
+    {
+        pa = tx; pb = ty;
+    }
+    else if(view == hoa_sym_view_xz)
+    {
+        pa = tx; pb = tz;
+    }
+    else
+    {
+        pa = ty; pb = tz;
+    }
+
+    if(radius != 0. && spatial)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            const double distance = sqrt(tx[i] * tx[i] + ty[i] * ty[i] + tz[i] * tz[i]);
+            const double scale = distance > 0. ? max(distance + radius, 0.) / distance : 1.;
+            tx[i] *= scale; ty[i] *= scale; tz[i] *= scale;
+            if(distance == 0.)
+                ty[i] = max(radius, 0.);
+        }
+    }
+    else if(radius != 0.)
+    {
+        for(size_t i = 0; i < size; i++)
+        {
+            const double distance = sqrt(pa[i] * pa[i] + pb[i] * pb[i]);
+            const double scale = distance > 0. ? max(distance + radius, 0.) / distance : 1.;
+            pa[i] *= scale; pb[i] *= scale;
+            if(distance == 0.)
+                pb[i] = max(radius, 0.);
+        }
+    }
+    if(azimuth != 0.)
+    {
+        const double c = cos(azimuth), s = sin(azimuth);
+        for(size_t i = 0; i < size; i++)
+        {
+            const double a = pa[i], b = pb[i];
+            pa[i] = a * c - b * s;
+            pb[i] = a * s + b * c;
+        }
+    }
+    for(size_t i = 0; i < size; i++)
+    {
+        tx[i] += dx; ty[i] += dy; tz[i] += dz;
+    }
+
+    for(size_t i = 0; i < size; i++)
+    {
+        st->f_sources[members[i]]->setCoordinatesCartesian(tx[i], ty[i], tz[i]);
+    }
+}
+
+//! Turns the sources of a group around the center in the plane of a view, the radius and the azimuth are offsets. The radius is the distance in space or in the plane.
+static void hoa_map_group_turn(t_hoa_map *x, Source::Group* group, t_symbol* view, const bool spatial, const double radius, const double azimuth)
+{
+    hoa_map_group_transform(x, group, view, spatial, radius, azimuth, 0., 0., 0.);
+}
+
+//! Moves the sources of a group so that its centroid reaches the coordinates.
+static void hoa_map_group_move(t_hoa_map *x, Source::Group* group, const double abscissa, const double ordinate, const double height)
+{
+    t_hoa_map_store* st = hoa_map_store(x);
+    const long slot = hoa_map_store_slot(st->f_gslots, group->getIndex());
+    if(slot >= 0)
+    {
+        hoa_map_group_transform(x, group, x->f_coord_view, false, 0., 0., abscissa - st->f_gx[slot], ordinate - st->f_gy[slot], height - st->f_gz[slot]);
+    }
+}
+
+extern "C" void setup_hoa0x2emap(void)
+{
+	t_eclass *c;
+
+	c = eclass_new("hoa.map", (method)hoa_map_new, (method)hoa_map_free, sizeof(t_hoa_map), 0L, A_GIMME, 0);
+    class_addcreator((t_newmethod)hoa_map_new, gensym("hoa.2d.map"), A_GIMME, 0);
+    class_addcreator((t_newmethod)hoa_map_new, gensym("hoa.3d.map"), A_GIMME, 0);
+
+    eclass_guiinit(c, 0);
+
+	eclass_addmethod(c, (method) hoa_map_paint,         "paint",          A_CANT,  0);
+	eclass_addmethod(c, (method) hoa_map_getDrawParams, "getDrawParams",  A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_oksize,        "oksize",         A_CANT,  0);
+	eclass_addmethod(c, (method) hoa_map_notify,        "notify",         A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_bang,          "bang",           A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_infos,         "getinfo",        A_GIMME, 0);
+
+    eclass_addmethod(c, (method) hoa_map_source,        "source",         A_GIMME, 0);
+    eclass_addmethod(c, (method) hoa_map_group,         "group",          A_GIMME, 0);
+    eclass_addmethod(c, (method) hoa_map_clearAll,      "clear",          A_GIMME, 0);
+	eclass_addmethod(c, (method) hoa_map_set,			"set",			  A_GIMME, 0);
+
+    eclass_addmethod(c, (method) hoa_map_mousedown,     "mousedown",      A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_mousedrag,     "mousedrag",      A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_mouseup,       "mouseup",        A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_mousemove,     "mousemove",      A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_mousewheel,    "mousewheel",     A_CANT,  0);
+	eclass_addmethod(c, (method) hoa_map_popup,         "popup",          A_CANT,  0);
+
+    eclass_addmethod(c, (method) hoa_map_preset,        "preset",         A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_interpolate,   "interpolate",    A_CANT,  0);
+    eclass_addmethod(c, (method) hoa_map_sourcesPreset, "sources_preset",  A_GIMME, 0);
+    eclass_addmethod(c, (method) hoa_map_read,          "read",           A_SYMBOL, 0);
+    eclass_addmethod(c, (method) hoa_map_write,         "write",          A_SYMBOL, 0);
+    eclass_addmethod(c, (method) hoa_map_trajectory,    "trajectory",     A_GIMME, 0);
+
+	CLASS_ATTR_DEFAULT              (c, "size", 0, "225 225");
+
+    CLASS_ATTR_RGBA					(c, "bgcolor", 0, t_hoa_map, f_color_bg);
+	CLASS_ATTR_CATEGORY				(c, "bgcolor", 0, "Color");
+	CLASS_ATTR_STYLE				(c, "bgcolor", 0, "rgba");
+	CLASS_ATTR_LABEL				(c, "bgcolor", 0, "Background Color");
+	CLASS_ATTR_DEFAULT_SAVE_PAINT	(c, "bgcolor", 0, "0.76 0.76 0.76 1.");
+
+    CLASS_ATTR_RGBA					(c, "bdcolor", 0, t_hoa_map, f_color_bd);
+	CLASS_ATTR_CATEGORY				(c, "bdcolor", 0, "Color");
+	CLASS_ATTR_STYLE                (c, "bdcolor", 0, "rgba");
+    CLASS_ATTR_LABEL				(c, "bdcolor", 0, "Border Color");
+	CLASS_ATTR_DEFAULT_SAVE_PAINT	(c, "bdcolor", 0, "0.7 0.7 0.7 1.");
+
+	CLASS_ATTR_SYMBOL				(c, "view", 0, t_hoa_map, f_coord_view);
 	CLASS_ATTR_LABEL				(c, "view", 0, "Coordinate View");
 	CLASS_ATTR_ITEMS				(c, "view", 0, "xy xz yz");
 	CLASS_ATTR_STYLE                (c, "view", 1, "menu");
@@ -196,6 +1149,33 @@ extern "C" void setup_hoa0x2emap(void)
     CLASS_ATTR_STYLE                (c, "outputmode", 1, "menu");
     CLASS_ATTR_ITEMS                (c, "outputmode", 1, "polar cartesian");
 
+    CLASS_ATTR_LONG                 (c, "delta", 0, t_hoa_map, f_delta);
+    CLASS_ATTR_ACCESSORS            (c, "delta", NULL, hoa_map_delta_set);
+	CLASS_ATTR_LABEL                (c, "delta", 0, "Changes Output Interval (in ms, 0 = off)");
+	CLASS_ATTR_CATEGORY             (c, "delta", 0, "Behavior");
+	CLASS_ATTR_DEFAULT              (c, "delta", 0, "0");
+    CLASS_ATTR_SAVE                 (c, "delta", 1);
+    CLASS_ATTR_ORDER                (c, "delta", 0, "1");
+    CLASS_ATTR_STYLE                (c, "delta", 0, "number");
+
+    CLASS_ATTR_LONG                 (c, "packed", 0, t_hoa_map, f_packed);
+	CLASS_ATTR_LABEL                (c, "packed", 0, "Packed Changes Output");
+	CLASS_ATTR_CATEGORY             (c, "packed", 0, "Behavior");
+	CLASS_ATTR_DEFAULT              (c, "packed", 0, "0");
+    CLASS_ATTR_FILTER_MIN           (c, "packed", 0);
+    CLASS_ATTR_SAVE                 (c, "packed", 1);
+    CLASS_ATTR_ORDER                (c, "packed", 0, "1");
+    CLASS_ATTR_STYLE                (c, "packed", 0, "number");
+
+    CLASS_ATTR_LONG                 (c, "compact", 0, t_hoa_map, f_compact);
+	CLASS_ATTR_LABEL                (c, "compact", 0, "Compact Presets");
+	CLASS_ATTR_CATEGORY             (c, "compact", 0, "Behavior");
+	CLASS_ATTR_DEFAULT              (c, "compact", 0, "0");
+    CLASS_ATTR_FILTER_MIN           (c, "compact", 0);
+    CLASS_ATTR_SAVE                 (c, "compact", 1);
+    CLASS_ATTR_ORDER                (c, "compact", 0, "1");
+    CLASS_ATTR_STYLE                (c, "compact", 0, "number");
+
 	CLASS_ATTR_DOUBLE               (c, "zoom", 0, t_hoa_map, f_zoom_factor);
     CLASS_ATTR_ACCESSORS            (c, "zoom", NULL, hoa_map_zoom);
 	CLASS_ATTR_LABEL                (c, "zoom", 0, "Zoom");
@@ -228,6 +1208,24 @@ void *hoa_map_new(t_symbol *s, int argc, t_atom *argv)
     {
         x->f_manager      = new Source::Manager(1. / (double)MIN_ZOOM - 5.);
         x->f_self_manager = x->f_manager;
+        x->f_store        = NULL;
+        x->f_changes      = new t_hoa_map_changes();
+        x->f_changes->f_all = false;
+        x->f_drawn_version  = 0;
+        x->f_output_version = 0;
+        x->f_interp       = new t_hoa_map_interp();
+        x->f_interp->f_version = 0;
+        x->f_trajectory   = new t_hoa_map_trajectory();
+        x->f_trajectory->f_recording = false;
+        x->f_trajectory->f_playing   = false;
+        x->f_trajectory->f_loop      = false;
+        x->f_trajectory->f_speed     = 1.;
+        x->f_trajectory->f_start     = 0.;
+        x->f_trajectory->f_position  = 0.;
+        x->f_trajectory->f_duration  = 0.;
+        x->f_trajectory->f_last      = 0.;
+        x->f_trajectory->f_clock     = clock_new(x, (t_method)hoa_map_trajectory_tick);
+        hoa_map_store_attach(x, hoa_map_store_new());
 
         x->f_rect_selection_exist = 0;
         x->f_read   = 0;
@@ -238,7 +1236,10 @@ void *hoa_map_new(t_symbol *s, int argc, t_atom *argv)
 
 		x->f_binding_name = hoa_sym_null;
 		x->f_listmap = NULL;
+        x->f_snapshot = NULL;
 		x->f_output_enabled = 1;
+        x->f_delta_wait     = 0;
+        x->f_delta_clock    = clock_new(x, (t_method)hoa_map_output_tick);
 
 		ebox_new((t_ebox *)x, 0 | EBOX_GROWLINK);
 
@@ -252,10 +1253,17 @@ void *hoa_map_new(t_symbol *s, int argc, t_atom *argv)
 
 void hoa_map_free(t_hoa_map *x)
 {
-	hoa_map_linkmapRemoveWithBindingName(x, x->f_binding_name);
+	hoa_map_linkmapRemoveWithBindingName(x, x->f_binding_name, true);
 
+    hoa_frame_unregister((t_ebox *)x);
+    clock_free(x->f_delta_clock);
+    clock_free(x->f_trajectory->f_clock);
     ebox_free((t_ebox *)x);
     delete x->f_self_manager;
+    hoa_map_store_release(x->f_store);
+    delete x->f_changes;
+    delete x->f_interp;
+    delete x->f_trajectory;
 }
 
 void hoa_map_linkmapAddWithBindingName(t_hoa_map *x, t_symbol* binding_name)
@@ -317,16 +1325,19 @@ void hoa_map_linkmapAddWithBindingName(t_hoa_map *x, t_symbol* binding_name)
 						temp2->next = NULL;
 						temp->next = temp2;
 						temp->next->map->f_manager = head_map->f_self_manager;
+						hoa_map_store_attach(x, head_map->f_store);
 					}
 					break;
 				}
 				temp = temp->next;
 			}
 		}
+        x->f_snapshot = hoa_map_snapshot_acquire((t_object *)x, binding_name);
 	}
+    x->f_store->f_stale = true;
 }
 
-void hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name)
+void hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name, bool freed)
 {
 	char strname[2048];
 	t_symbol* name = NULL;
@@ -335,6 +1346,12 @@ void hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name)
     if(!binding_name || binding_name == hoa_sym_nothing || binding_name == hoa_sym_null)
         return;
 
+    if(x->f_snapshot)
+    {
+        hoa_map_snapshot_release((t_object *)x, binding_name);
+        x->f_snapshot = NULL;
+    }
+
 	if(canvas)
 	{
 		sprintf(strname, "p%ld_%s_%s", (ulong)canvas, binding_name->s_name, ODD_BINDING_SUFFIX);
@@ -349,6 +1366,7 @@ void hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name)
 
 			while(temp)
 			{
+                temp->map->f_store->f_stale = true;
 				if (counter == 0 && temp->map == x) // head of the linkmap
 				{
 					head_map = temp->map;
@@ -362,8 +1380,28 @@ void hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name)
 						name->s_thing = (t_class **)temp->next;
 
 						// bind all object to the next Source::Manager (next becoming the new head of the t_linkmap)
-						temp->next->map->f_self_manager = new Source::Manager(*head_map->f_manager);
-						temp->next->update_headptr((t_linkmap *)name->s_thing, temp->next->map->f_self_manager);
+						delete temp->next->map->f_self_manager;
+						if(freed)
+						{
+							// the object is freed so its Source::Manager and the store are handed over without copy
+							temp->next->map->f_self_manager = head_map->f_self_manager;
+							x->f_self_manager = NULL;
+							temp->next->update_headptr((t_linkmap *)name->s_thing, temp->next->map->f_self_manager);
+						}
+						else
+						{
+							temp->next->map->f_self_manager = new Source::Manager(*head_map->f_manager);
+							temp->next->update_headptr((t_linkmap *)name->s_thing, temp->next->map->f_self_manager);
+
+							// the remaining objects share a new store that reads the copy
+							t_hoa_map_store* st = hoa_map_store_new();
+							for(temp2 = temp->next; temp2; temp2 = temp2->next)
+							{
+								hoa_map_store_attach(temp2->map, st);
+								temp2->map->f_selected_source = NULL;
+								temp2->map->f_selected_group = NULL;
+							}
+						}
 					}
 
                     //free(x->f_listmap);
@@ -373,10 +1411,17 @@ void hoa_map_linkmapRemoveWithBindingName(t_hoa_map *x, t_symbol* binding_name)
 				}
 				else if(temp->next != NULL && temp->next->map == x)
 				{
-					// we restore the original pointer
-					temp->next->map->f_manager = temp->next->map->f_manager;
-					// then we copy the shared Source::Manager into the original one
-					temp->next->map->f_manager = new Source::Manager(*head_map->f_self_manager);
+					// we copy the shared Source::Manager into the original one, unless the object is freed
+					x->f_manager = x->f_self_manager;
+					if(!freed)
+					{
+						delete x->f_self_manager;
+						x->f_self_manager = new Source::Manager(*head_map->f_self_manager);
+						x->f_manager = x->f_self_manager;
+						x->f_selected_source = NULL;
+						x->f_selected_group = NULL;
+						hoa_map_store_attach(x, hoa_map_store_new());
+					}
 
 					temp2 = temp->next->next;
 					free(temp->next);
@@ -409,10 +1454,11 @@ t_pd_err hoa_map_bindnameSet(t_hoa_map *x, void *attr, int argc, t_atom *argv)
 				x->f_binding_name = hoa_sym_null;
             }
 
+            hoa_map_touch(x);
             ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-            ebox_redraw((t_ebox *)x);
+            hoa_frame_redraw((t_ebox *)x);
             hoa_map_output(x);
 		}
 	}
@@ -439,9 +1485,8 @@ void hoa_map_sendBindedMapUpdate(t_hoa_map *x, long flags)
 			{
 				if (flags & BMAP_REDRAW)
 				{
-					ebox_invalidate_layer((t_ebox *)mapobj, hoa_sym_sources_layer);
-					ebox_invalidate_layer((t_ebox *)mapobj, hoa_sym_groups_layer);
-					ebox_redraw((t_ebox *)mapobj);
+					// the layers are invalidated by the paint method if the version of the store changed
+					hoa_frame_redraw((t_ebox *)mapobj);
 				}
 				if (flags & BMAP_NOTIFY)
 				{
@@ -449,7 +1494,11 @@ void hoa_map_sendBindedMapUpdate(t_hoa_map *x, long flags)
 				}
 				if (flags & BMAP_OUTPUT && x->f_output_enabled)
 				{
-					pd_bang((t_pd *)mapobj);
+					hoa_map_output((t_hoa_map *)mapobj);
+				}
+				if (flags & BMAP_FLUSH && x->f_output_enabled)
+				{
+					hoa_map_output_all((t_hoa_map *)mapobj);
 				}
 			}
 
@@ -474,11 +1523,10 @@ void hoa_map_oksize(t_hoa_map *x, t_rect *newrect)
 
 void hoa_map_isElementSelected(t_hoa_map *x, t_pt pt)
 {
-    t_pt cursor, displayed_coords;
+    t_pt cursor;
     cursor.x = ((pt.x / x->rect.width * 2.) - 1.) / x->f_zoom_factor;
     cursor.y = ((-pt.y / x->rect.height * 2.) + 1.) / x->f_zoom_factor;
 	double distanceSelected = ebox_getfontsize((t_ebox *)x) / (x->f_zoom_factor * 2. * x->rect.width);
-	double distanceSelected_test;
 
     x->f_cursor_position.x = cursor.x;
     x->f_cursor_position.y = cursor.y;
@@ -486,58 +1534,22 @@ void hoa_map_isElementSelected(t_hoa_map *x, t_pt pt)
     x->f_selected_source = NULL;
     x->f_selected_group = NULL;
 
-	for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource() ; it ++)
+    t_hoa_map_store* st = hoa_map_store(x);
+    const int grid = hoa_map_store_grid(x->f_coord_view);
+    const double *px, *py;
+    hoa_map_store_plane(x->f_coord_view, st->f_sx, st->f_sy, st->f_sz, px, py);
+    long slot = hoa_map_grid_nearest(st->f_sgrids+grid, px, py, cursor.x, cursor.y, distanceSelected);
+    if(slot >= 0)
     {
-        if(x->f_coord_view == hoa_sym_view_xy)
-        {
-            displayed_coords.x = it->second->getAbscissa();
-            displayed_coords.y = it->second->getOrdinate();
-        }
-        else if(x->f_coord_view == hoa_sym_view_xz)
-        {
-            displayed_coords.x = it->second->getAbscissa();
-            displayed_coords.y = it->second->getHeight();
-        }
-        else
-        {
-            displayed_coords.x = it->second->getOrdinate();
-            displayed_coords.y = it->second->getHeight();
-        }
-		distanceSelected_test = hoa_pd_distance(displayed_coords.x, displayed_coords.y, cursor.x, cursor.y);
-
-        if(distanceSelected_test <= distanceSelected)
-        {
-            distanceSelected = distanceSelected_test;
-            x->f_selected_source = it->second;
-        }
+        x->f_selected_source = st->f_sources[slot];
     }
-
-    if(!x->f_selected_source)
+    else
     {
-        for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup() ; it ++)
+        hoa_map_store_plane(x->f_coord_view, st->f_gx, st->f_gy, st->f_gz, px, py);
+        slot = hoa_map_grid_nearest(st->f_ggrids+grid, px, py, cursor.x, cursor.y, distanceSelected);
+        if(slot >= 0)
         {
-            if(x->f_coord_view == hoa_sym_view_xy)
-            {
-                displayed_coords.x = it->second->getAbscissa();
-                displayed_coords.y = it->second->getOrdinate();
-            }
-            else if(x->f_coord_view == hoa_sym_view_xz)
-            {
-                displayed_coords.x = it->second->getAbscissa();
-                displayed_coords.y = it->second->getHeight();
-            }
-            else
-            {
-                displayed_coords.x = it->second->getOrdinate();
-                displayed_coords.y = it->second->getHeight();
-            }
-			distanceSelected_test = hoa_pd_distance(displayed_coords.x, displayed_coords.y, cursor.x, cursor.y);
-
-			if(distanceSelected_test <= distanceSelected)
-			{
-				distanceSelected = distanceSelected_test;
-				x->f_selected_group = it->second;
-			}
+            x->f_selected_group = st->f_groups[slot];
         }
     }
 }
@@ -549,19 +1561,23 @@ void hoa_map_isElementSelected(t_hoa_map *x, t_pt pt)
 void hoa_map_clearAll(t_hoa_map *x)
 {
 	// mute all source and output before clearing them to notify hoa.#.map~
-	for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource() ; it ++)
-			it->second->setMute(true);
+    t_hoa_map_store* st = hoa_map_store(x);
+	for(size_t i = 0; i < st->f_sources.size(); i++)
+			st->f_sources[i]->setMute(true);
+    hoa_map_touch(x);
 
-	hoa_map_output(x);
-	hoa_map_sendBindedMapUpdate(x, BMAP_OUTPUT);
+	if (x->f_output_enabled)
+		hoa_map_output_all(x);
+	hoa_map_sendBindedMapUpdate(x, BMAP_FLUSH);
 
 	// now we can clear, then notify, output and redraw all maps
     x->f_manager->clear();
 
+    hoa_map_touch(x);
     ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-    ebox_redraw((t_ebox *)x);
+    hoa_frame_redraw((t_ebox *)x);
     hoa_map_output(x);
 	hoa_map_sendBindedMapUpdate(x, BMAP_REDRAW | BMAP_OUTPUT | BMAP_NOTIFY);
 }
@@ -581,16 +1597,31 @@ void hoa_map_set(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
 	x->f_output_enabled = 1;
 }
 
+//! Returns true if an atom is the index of a source or a group.
+/** The tables of the store are indexed by the indices of the sources and the groups, so they are limited between 1 and HOA_MAP_MAXINDEX.
+ */
+static bool hoa_map_isindex(t_hoa_map *x, t_atom const* av)
+{
+    if(atom_gettype(av) == A_LONG && atom_getfloat(av) >= 1)
+    {
+        if(atom_getfloat(av) <= HOA_MAP_MAXINDEX)
+            return true;
+        pd_error(x, "hoa.map: the index %g is above the maximum %d.", atom_getfloat(av), HOA_MAP_MAXINDEX);
+    }
+    return false;
+}
+
 void hoa_map_source(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
 {
     long index;
-    if(ac && av && atom_gettype(av)==A_LONG && atom_getlong(av) >= 1 && atom_gettype(av+1) == A_SYM)
+    if(ac > 1 && av && hoa_map_isindex(x, av) && atom_gettype(av+1) == A_SYM)
     {
 		t_symbol* param = atom_getsym(av+1);
         index = atom_getlong(av);
 		int causeOutput = 1;
         if (index > 0)
         {
+            const bool exist = hoa_map_store_slot(hoa_map_store(x)->f_sslots, ulong(index)) >= 0;
             Source* tmp = x->f_manager->newSource(ulong(index));
 
             if(param == hoa_sym_polar || param == hoa_sym_pol)
@@ -642,9 +1673,10 @@ void hoa_map_source(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
                     if(atom_getsym(av+2) == hoa_sym_remove)
                     {
                         tmp->setDescription("");
+                        hoa_map_touch(x);
                         ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
                         ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
-                        ebox_redraw((t_ebox *)x);
+                        hoa_frame_redraw((t_ebox *)x);
                         return;
                     }
                 }
@@ -678,10 +1710,14 @@ void hoa_map_source(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
                 causeOutput = 0;
             }
 
+            if(exist && param != hoa_sym_remove)
+                hoa_map_refresh(x, tmp);
+            else
+                hoa_map_touch(x);
             ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-            ebox_redraw((t_ebox *)x);
+            hoa_frame_redraw((t_ebox *)x);
 
             if (causeOutput)
             {
@@ -695,11 +1731,12 @@ void hoa_map_source(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
 
 void hoa_map_group(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
 {
-    if(ac && av && atom_gettype(av) == A_LONG && atom_getlong(av) >= 1 && atom_gettype(av+1) == A_SYM)
+    if(ac > 1 && av && hoa_map_isindex(x, av) && atom_gettype(av+1) == A_SYM)
     {
         ulong index = ulong(atom_getlong(av));
 		t_symbol* param = atom_getsym(av+1);
 		int causeOutput = 1;
+        Source::Group* moved = NULL;
 		if (index > 0)
         {
             bool newGroupCreated = false;
@@ -714,10 +1751,9 @@ void hoa_map_group(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
             {
                 for(int i = 2; i < ac; i++)
                 {
-                    ulong ind = ulong(atom_getlong(av+i));
-                    if (ind > 0)
+                    if (hoa_map_isindex(x, av+i))
                     {
-                        Source* src = x->f_manager->newSource(ind);
+                        Source* src = x->f_manager->newSource(ulong(atom_getlong(av+i)));
                         tmp->addSource(src);
                     }
                 }
@@ -736,16 +1772,16 @@ void hoa_map_group(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
             else if(param == hoa_sym_cartesian || param == hoa_sym_car)
             {
                 if (ac >= 5 && atom_isNumber(av+2) && atom_isNumber(av+3) && atom_isNumber(av+4))
-                    tmp->setCoordinatesCartesian(atom_getfloat(av+2), atom_getfloat(av+3), atom_getfloat(av+4));
+                    hoa_map_group_move(x, tmp, atom_getfloat(av+2), atom_getfloat(av+3), atom_getfloat(av+4));
                 else if (ac >= 4 && atom_isNumber(av+2) && atom_isNumber(av+3))
-                    tmp->setCoordinatesCartesian(atom_getfloat(av+2), atom_getfloat(av+3));
+                    hoa_map_group_move(x, tmp, atom_getfloat(av+2), atom_getfloat(av+3), tmp->getHeight());
             }
             else if(param == hoa_sym_abscissa)
-                tmp->setAbscissa(atom_getfloat(av+2));
+                hoa_map_group_move(x, tmp, atom_getfloat(av+2), tmp->getOrdinate(), tmp->getHeight());
             else if(param == hoa_sym_ordinate)
-                tmp->setOrdinate(atom_getfloat(av+2));
+                hoa_map_group_move(x, tmp, tmp->getAbscissa(), atom_getfloat(av+2), tmp->getHeight());
             else if(param == hoa_sym_height)
-                tmp->setHeight(atom_getfloat(av+2));
+                hoa_map_group_move(x, tmp, tmp->getAbscissa(), tmp->getOrdinate(), atom_getfloat(av+2));
             else if(param == hoa_sym_relpolar)
             {
                 if (ac >= 5 && atom_isNumber(av+2) && atom_isNumber(av+3) && atom_isNumber(av+4))
@@ -755,48 +1791,11 @@ void hoa_map_group(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
             }
             else if(param == hoa_sym_relradius)
             {
-                tmp->setRelativeRadius(atom_getfloat(av+2) + tmp->getRadius());
+                hoa_map_group_turn(x, tmp, hoa_sym_view_xy, true, atom_getfloat(av+2), 0.);
             }
             else if(param == hoa_sym_relazimuth)
             {
-                if(x->f_coord_view == hoa_sym_view_xy)
-                {
-                    tmp->setRelativeAzimuth(atom_getfloat(av+2) + tmp->getAzimuth());
-                }
-                else if(x->f_coord_view == hoa_sym_view_xz)
-                {
-                    t_pt source_display;
-                    double source_radius, source_azimuth, aAngleOffset = atom_getfloat(av+2);
-                    map<ulong, Source*>& sourcesOfGroup = tmp->getSources();
-                    for(Source::source_iterator it = sourcesOfGroup.begin() ; it != sourcesOfGroup.end() ; it ++)
-                    {
-                        source_display.x = it->second->getAbscissa();
-                        source_display.y = it->second->getHeight();
-                        source_radius = Math<float>::radius(source_display.x, source_display.y);
-                        source_azimuth = Math<float>::azimuth(source_display.x, source_display.y);
-                        source_azimuth += aAngleOffset;
-
-                        it->second->setAbscissa(Math<float>::abscissa(source_radius, source_azimuth));
-                        it->second->setHeight(Math<float>::ordinate(source_radius, source_azimuth));
-                    }
-                }
-                else
-                {
-                    t_pt source_display;
-                    double source_radius, source_azimuth, aAngleOffset = atom_getfloat(av+2);
-                    map<ulong, Source*>& sourcesOfGroup = tmp->getSources();
-                    for(Source::source_iterator it = sourcesOfGroup.begin() ; it != sourcesOfGroup.end() ; it ++)
-                    {
-                        source_display.x = it->second->getOrdinate();
-                        source_display.y = it->second->getHeight();
-                        source_radius = Math<float>::radius(source_display.x, source_display.y);
-                        source_azimuth = Math<float>::azimuth(source_display.x, source_display.y);
-                        source_azimuth += aAngleOffset;
-
-                        it->second->setOrdinate(Math<float>::abscissa(source_radius, source_azimuth));
-                        it->second->setHeight(Math<float>::ordinate(source_radius, source_azimuth));
-                    }
-                }
+                hoa_map_group_turn(x, tmp, x->f_coord_view, false, 0., atom_getfloat(av+2));
             }
             else if(param == hoa_sym_relelevation)
             {
@@ -827,9 +1826,10 @@ void hoa_map_group(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
                     if(atom_getsym(av+2) == hoa_sym_remove)
                     {
                         tmp->setDescription("");
+                        hoa_map_touch(x);
                         ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
                         ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-                        ebox_redraw((t_ebox *)x);
+                        hoa_frame_redraw((t_ebox *)x);
                         return;
                     }
                 }
@@ -870,12 +1870,20 @@ void hoa_map_group(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
                     delete tmp;
                 }
             }
+            else if(param != hoa_sym_set && param != hoa_sym_remove && param != hoa_sym_description && param != hoa_sym_color)
+            {
+                moved = tmp;
+            }
         }
 
+        if(moved)
+            hoa_map_refresh_group(x, moved);
+        else
+            hoa_map_touch(x);
 		ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-		ebox_redraw((t_ebox *)x);
+		hoa_frame_redraw((t_ebox *)x);
 		if (causeOutput)
 		{
 			hoa_map_output(x);
@@ -911,7 +1919,7 @@ t_pd_err hoa_map_notify(t_hoa_map *x, t_symbol *s, t_symbol *msg, void *sender,
         {
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-            ebox_redraw((t_ebox *)x);
+            hoa_frame_redraw((t_ebox *)x);
         }
         else if(s == gensym("zoom"))
         {
@@ -928,79 +1936,204 @@ t_pd_err hoa_map_notify(t_hoa_map *x, t_symbol *s, t_symbol *msg, void *sender,
 /*                          Sortie                        */
 /**********************************************************/
 
-void hoa_map_output(t_hoa_map *x)
+void hoa_map_bang(t_hoa_map *x)
 {
-	if (!x->f_output_enabled)
-		return;
+    // the versions start at 1 so the scene is output even if it didn't change
+    x->f_changes->f_all = true;
+    x->f_output_version = 0;
+    hoa_map_output(x);
+}
 
+//! Outputs the state of all the groups and the sources.
+void hoa_map_output_all(t_hoa_map *x)
+{
 	t_atom av[5];
+    t_hoa_map_store* st = hoa_map_store(x);
+    hoa_map_changes_clear(x->f_changes);
+    x->f_output_version = st->f_version;
+    const size_t ngroups  = st->f_groups.size();
+    const size_t nsources = st->f_sources.size();
     atom_setsym(av+1, hoa_sym_mute);
 
 	// output group mute state
-	for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup(); it ++)
+	for(size_t i = 0; i < ngroups; i++)
     {
-        atom_setlong(av, it->first);
-        atom_setfloat(av+2, it->second->getMute());
+        atom_setlong(av, st->f_gindices[i]);
+        atom_setfloat(av+2, st->f_gmute[i]);
         outlet_list(x->f_out_groups, 0L, 3, av);
     }
 	// output source mute state
-    for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource(); it ++)
+    for(size_t i = 0; i < nsources; i++)
     {
-        atom_setlong(av, it->first);
-        atom_setlong(av+2, it->second->getMute());
+        atom_setlong(av, st->f_sindices[i]);
+        atom_setlong(av+2, st->f_smute[i]);
         outlet_list(x->f_out_sources, 0L, 3, av);
     }
     if(x->f_output_mode == hoa_sym_polar)
     {
         atom_setsym(av+1, hoa_sym_polar);
-		for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup(); it ++)
+		for(size_t i = 0; i < ngroups; i++)
         {
-            atom_setlong(av, it->first);
-            atom_setfloat(av+2, it->second->getRadius());
-            atom_setfloat(av+3, it->second->getAzimuth());
-            atom_setfloat(av+4, it->second->getElevation());
+            atom_setlong(av, st->f_gindices[i]);
+            atom_setfloat(av+2, st->f_gr[i]);
+            atom_setfloat(av+3, st->f_ga[i]);
+            atom_setfloat(av+4, st->f_ge[i]);
             outlet_list(x->f_out_groups, 0L, 5, av);
         }
-        for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource(); it ++)
+        for(size_t i = 0; i < nsources; i++)
         {
-            atom_setlong(av, it->first);
-            atom_setfloat(av+2, it->second->getRadius());
-            atom_setfloat(av+3, it->second->getAzimuth());
-            atom_setfloat(av+4, it->second->getElevation());
+            atom_setlong(av, st->f_sindices[i]);
+            atom_setfloat(av+2, st->f_sr[i]);
+            atom_setfloat(av+3, st->f_sa[i]);
+            atom_setfloat(av+4, st->f_se[i]);
             outlet_list(x->f_out_sources, 0L, 5, av);
         }
     }
     else
     {
         atom_setsym(av+1, hoa_sym_cartesian);
-		for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup(); it ++)
+		for(size_t i = 0; i < ngroups; i++)
         {
-            atom_setlong(av, it->first);
-            atom_setfloat(av+2, it->second->getAbscissa());
-            atom_setfloat(av+3, it->second->getOrdinate());
-            atom_setfloat(av+4, it->second->getHeight());
+            atom_setlong(av, st->f_gindices[i]);
+            atom_setfloat(av+2, st->f_gx[i]);
+            atom_setfloat(av+3, st->f_gy[i]);
+            atom_setfloat(av+4, st->f_gz[i]);
             outlet_list(x->f_out_groups, 0L, 5, av);
         }
-        for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource(); it ++)
+        for(size_t i = 0; i < nsources; i++)
         {
-            atom_setlong(av, it->first);
-            atom_setfloat(av+2, it->second->getAbscissa());
-            atom_setfloat(av+3, it->second->getOrdinate());
-            atom_setfloat(av+4, it->second->getHeight());
+            atom_setlong(av, st->f_sindices[i]);
+            atom_setfloat(av+2, st->f_sx[i]);
+            atom_setfloat(av+3, st->f_sy[i]);
+            atom_setfloat(av+4, st->f_sz[i]);
             outlet_list(x->f_out_sources, 0L, 5, av);
         }
     }
 }
 
+//! Outputs the groups and the sources that changed since the last output, one tuple of index, mute and coordinates per element in packed mode.
+static void hoa_map_output_changes(t_hoa_map *x)
+{
+    t_hoa_map_store* st = hoa_map_store(x);
+    t_hoa_map_changes* ch = x->f_changes;
+    if(ch->f_all)
+    {
+        hoa_map_output_all(x);
+        return;
+    }
+
+    const bool polar = x->f_output_mode == hoa_sym_polar;
+    t_symbol* mode = polar ? hoa_sym_polar : hoa_sym_cartesian;
+    sort(ch->f_groups.begin(), ch->f_groups.end());
+    sort(ch->f_sources.begin(), ch->f_sources.end());
+    for(int k = 0; k < 2; k++)
+    {
+        vector<ulong> const& changed    = k ? ch->f_sources : ch->f_groups;
+        vector<long> const& slots       = k ? st->f_sslots : st->f_gslots;
+        vector<char> const& mute        = k ? st->f_smute : st->f_gmute;
+        vector<double> const& c1        = k ? (polar ? st->f_sr : st->f_sx) : (polar ? st->f_gr : st->f_gx);
+        vector<double> const& c2        = k ? (polar ? st->f_sa : st->f_sy) : (polar ? st->f_ga : st->f_gy);
+        vector<double> const& c3        = k ? (polar ? st->f_se : st->f_sz) : (polar ? st->f_ge : st->f_gz);
+        t_outlet* out                   = k ? x->f_out_sources : x->f_out_groups;
+
+        if(x->f_packed)
+        {
+            vector<t_atom> av(changed.size() * 5);
+            size_t n = 0;
+            for(size_t i = 0; i < changed.size(); i++)
+            {
+                const long slot = hoa_map_store_slot(slots, changed[i]);
+                if(slot >= 0)
+                {
+                    atom_setlong(&av[n], changed[i]);
+                    atom_setlong(&av[n+1], mute[slot]);
+                    atom_setfloat(&av[n+2], c1[slot]);
+                    atom_setfloat(&av[n+3], c2[slot]);
+                    atom_setfloat(&av[n+4], c3[slot]);
+                    n += 5;
+                }
+            }
+            if(n)
+                outlet_anything(out, mode, int(n), av.data());
+        }
+        else
+        {
+            t_atom av[5];
+            for(size_t i = 0; i < changed.size(); i++)
+            {
+                const long slot = hoa_map_store_slot(slots, changed[i]);
+                if(slot >= 0)
+                {
+                    atom_setlong(av, changed[i]);
+                    atom_setsym(av+1, hoa_sym_mute);
+                    atom_setlong(av+2, mute[slot]);
+                    outlet_list(out, 0L, 3, av);
+                    atom_setsym(av+1, mode);
+                    atom_setfloat(av+2, c1[slot]);
+                    atom_setfloat(av+3, c2[slot]);
+                    atom_setfloat(av+4, c3[slot]);
+                    outlet_list(out, 0L, 5, av);
+                }
+            }
+        }
+    }
+    hoa_map_changes_clear(ch);
+    x->f_output_version = st->f_version;
+}
+
+//! Outputs the pending changes then waits for the interval of the delta output before the next ones.
+void hoa_map_output_tick(t_hoa_map *x)
+{
+    x->f_delta_wait = 0;
+    if(x->f_delta > 0 && !hoa_map_changes_empty(x->f_changes))
+    {
+        hoa_map_output_changes(x);
+        x->f_delta_wait = 1;
+        clock_delay(x->f_delta_clock, x->f_delta);
+    }
+}
+
+void hoa_map_output(t_hoa_map *x)
+{
+	if (!x->f_output_enabled)
+		return;
+
+    if(x->f_delta > 0)
+    {
+        if(!x->f_delta_wait)
+            hoa_map_output_tick(x);
+    }
+    else if(x->f_output_version != x->f_store->f_version)
+    {
+        hoa_map_output_all(x);
+    }
+}
+
+t_pd_err hoa_map_delta_set(t_hoa_map *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        const long delta = atom_getlong(argv);
+        x->f_delta = delta > 0 ? delta : 0;
+        if(!x->f_delta)
+        {
+            clock_unset(x->f_delta_clock);
+            x->f_delta_wait = 0;
+        }
+    }
+    return 0;
+}
+
 void hoa_map_infos(t_hoa_map *x)
 {
     t_atom avNumber[3];
     t_atom* avIndex;
     t_atom* avSource;
     t_atom avMute[4];
+    t_hoa_map_store* st = hoa_map_store(x);
 
     // Sources
-    ulong numberOfSource = x->f_manager->getNumberOfSources();
+    ulong numberOfSource = st->f_sources.size();
     atom_setsym(avNumber, hoa_sym_source);
     atom_setsym(avNumber+1, hoa_sym_number);
     atom_setlong(avNumber+2, numberOfSource);
@@ -1009,27 +2142,24 @@ void hoa_map_infos(t_hoa_map *x)
     avIndex = new t_atom[numberOfSource+2];
     atom_setsym(avIndex, hoa_sym_source);
     atom_setsym(avIndex+1, hoa_sym_index);
-
-    ulong j = 0;
-    for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource(); it ++)
+    for(ulong i = 0; i < numberOfSource; i++)
     {
-        atom_setlong(avIndex+j+2, it->first);
-        j ++;
+        atom_setlong(avIndex+i+2, st->f_sindices[i]);
     }
     outlet_list(x->f_out_infos, 0L, int(numberOfSource+2), avIndex);
     delete [] avIndex;
 
     atom_setsym(avMute, hoa_sym_source);
     atom_setsym(avMute+1, hoa_sym_mute);
-    for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource(); it ++)
+    for(ulong i = 0; i < numberOfSource; i++)
     {
-        atom_setlong(avMute+2, it->first);
-        atom_setlong(avMute+3, it->second->getMute());
+        atom_setlong(avMute+2, st->f_sindices[i]);
+        atom_setlong(avMute+3, st->f_smute[i]);
         outlet_list(x->f_out_infos, &s_list, 4, avMute);
     }
 
     // Groups
-    ulong numberOfGroups = x->f_manager->getNumberOfGroups();
+    ulong numberOfGroups = st->f_groups.size();
     atom_setsym(avNumber, hoa_sym_group);
     atom_setsym(avNumber+1, hoa_sym_number);
     atom_setlong(avNumber+2, numberOfGroups);
@@ -1038,40 +2168,35 @@ void hoa_map_infos(t_hoa_map *x)
     avIndex = new t_atom[numberOfGroups+2];
     atom_setsym(avIndex, hoa_sym_group);
     atom_setsym(avIndex+1, hoa_sym_index);
-    j = 0;
-    for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup(); it ++)
+    for(ulong i = 0; i < numberOfGroups; i++)
     {
-        atom_setlong(avIndex+j+2, it->first);
-        j++;
+        atom_setlong(avIndex+i+2, st->f_gindices[i]);
     }
     outlet_list(x->f_out_infos, &s_list, int(numberOfGroups+2), avIndex);
     delete [] avIndex;
 
-    for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup(); it ++)
+    for(ulong i = 0; i < numberOfGroups; i++)
     {
-        avSource = new t_atom[it->second->getNumberOfSources()+3];
+        const ulong first = st->f_gsources_offsets[i];
+        const ulong count = st->f_gsources_offsets[i+1] - first;
+        avSource = new t_atom[count+3];
         atom_setsym(avSource, hoa_sym_group);
         atom_setsym(avSource+1, hoa_sym_source);
-        atom_setlong(avSource+2, it->first);
-
-        j = 0;
-        map<ulong, Source*>& sourcesOfGroup = it->second->getSources();
-        for(Source::source_iterator ti = sourcesOfGroup.begin() ; ti != sourcesOfGroup.end(); ti ++)
+        atom_setlong(avSource+2, st->f_gindices[i]);
+        for(ulong j = 0; j < count; j++)
         {
-            atom_setlong(avSource+3+j, ti->first);
-            j ++;
+            atom_setlong(avSource+3+j, st->f_sindices[st->f_gsources[first+j]]);
         }
-        outlet_list(x->f_out_infos, &s_list, int(it->second->getNumberOfSources()+3), avSource);
+        outlet_list(x->f_out_infos, &s_list, int(count+3), avSource);
         delete [] avSource;
     }
 
-
     atom_setsym(avMute, hoa_sym_group);
     atom_setsym(avMute+1, hoa_sym_mute);
-    for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup(); it ++)
+    for(ulong i = 0; i < numberOfGroups; i++)
     {
-        atom_setlong(avMute+2, it->first);
-        atom_setlong(avMute+3, it->second->getMute());
+        atom_setlong(avMute+2, st->f_gindices[i]);
+        atom_setlong(avMute+3, st->f_gmute[i]);
         outlet_list(x->f_out_infos, &s_list, 4, avMute);
     }
 }
@@ -1086,9 +2211,17 @@ void hoa_map_paint(t_hoa_map *x, t_object *view)
     ebox_get_rect_for_view((t_ebox *)x, &rect);
 	x->rect = rect;
 
-	hoa_map_drawBackground(x, view, &rect);
-    hoa_map_drawRectSelection(x, view, &rect);
-    hoa_map_drawSources(x, view, &rect);
+    // the store may have been changed by a bound map since the last paint
+    if(x->f_drawn_version != x->f_store->f_version)
+    {
+        ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
+        ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
+        x->f_drawn_version = x->f_store->f_version;
+    }
+
+	hoa_map_drawBackground(x, view, &rect);
+    hoa_map_drawRectSelection(x, view, &rect);
+    hoa_map_drawSources(x, view, &rect);
     hoa_map_drawGroups(x, view, &rect);
 }
 
@@ -1189,33 +2322,25 @@ void hoa_map_drawSources(t_hoa_map *x,  t_object *view, t_rect *rect)
         jtl = etext_layout_create();
         egraphics_set_line_width(g, 1.);
 
-		for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource() ; it ++)
+        t_hoa_map_store* st = hoa_map_store(x);
+        const double *px, *py, *gx, *gy;
+        hoa_map_store_plane(x->f_coord_view, st->f_sx, st->f_sy, st->f_sz, px, py);
+        hoa_map_store_plane(x->f_coord_view, st->f_gx, st->f_gy, st->f_gz, gx, gy);
+		for(size_t i = 0; i < st->f_sources.size(); i++)
         {
-            if(x->f_coord_view == hoa_sym_view_xy)
-            {
-                sourceDisplayPos.x = (it->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                sourceDisplayPos.y = (-it->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.y;
-            }
-            else if(x->f_coord_view == hoa_sym_view_xz)
-            {
-                sourceDisplayPos.x = (it->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                sourceDisplayPos.y = (-it->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-            }
-            else
-            {
-                sourceDisplayPos.x = (it->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.x;
-                sourceDisplayPos.y = (-it->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-            }
-            //post("%f : (%f %f %f)", float(it->second->getElevation()), float(it->second->getAbscissa()), float(it->second->getOrdinate()), float(it->second->getHeight()));
-            sourceColor.red = it->second->getColor()[0];
-            sourceColor.green = it->second->getColor()[1];
-            sourceColor.blue = it->second->getColor()[2];
-            sourceColor.alpha = it->second->getColor()[3];
+            Source* src = st->f_sources[i];
+            sourceDisplayPos.x = (px[i] * x->f_zoom_factor + 1.) * ctr.x;
+            sourceDisplayPos.y = (-py[i] * x->f_zoom_factor + 1.) * ctr.y;
 
-            if(it->second->getDescription().c_str()[0])
-                sprintf(description,"%i : %s", (int)it->first, it->second->getDescription().c_str());
+            sourceColor.red = src->getColor()[0];
+            sourceColor.green = src->getColor()[1];
+            sourceColor.blue = src->getColor()[2];
+            sourceColor.alpha = src->getColor()[3];
+
+            if(src->getDescription().c_str()[0])
+                sprintf(description,"%i : %s", (int)st->f_sindices[i], src->getDescription().c_str());
             else
-                sprintf(description,"%i", (int)it->first);
+                sprintf(description,"%i", (int)st->f_sindices[i]);
 
             textDisplayPos.x = sourceDisplayPos.x - 2. * source_size;
             textDisplayPos.y = sourceDisplayPos.y - source_size - font_size - 1.;
@@ -1224,39 +2349,24 @@ void hoa_map_drawSources(t_hoa_map *x,  t_object *view, t_rect *rect)
             etext_layout_set(jtl, description, &x->j_box.b_font, textDisplayPos.x, textDisplayPos.y, font_size * 10., font_size * 2., ETEXT_LEFT, ETEXT_JCENTER, ETEXT_NOWRAP);
             etext_layout_draw(jtl, g);
 
-            if (x->f_selected_source && x->f_selected_source->getIndex() == it->first)
+            if (x->f_selected_source == src)
             {
                 egraphics_set_color_rgba(g, &color_sel);
                 egraphics_circle(g, sourceDisplayPos.x, sourceDisplayPos.y, source_size * 1.5);
                 egraphics_fill(g);
 
-                map<ulong, Source::Group*>& groupsOfSources = it->second->getGroups();
-                for(Source::group_iterator ti = groupsOfSources.begin() ; ti != groupsOfSources.end() ; ti ++)
+                for(ulong j = st->f_sgroups_offsets[i]; j < st->f_sgroups_offsets[i+1]; j++)
                 {
+                    const ulong grp = st->f_sgroups[j];
                     egraphics_move_to(g, sourceDisplayPos.x, sourceDisplayPos.y);
-
-                    if(x->f_coord_view == hoa_sym_view_xy)
-                    {
-                        groupDisplayPos.x = (ti->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                        groupDisplayPos.y = (-ti->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.y;
-                    }
-                    else if(x->f_coord_view == hoa_sym_view_xz)
-                    {
-                        groupDisplayPos.x = (ti->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                        groupDisplayPos.y = (-ti->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-                    }
-                    else
-                    {
-                        groupDisplayPos.x = (ti->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.x;
-                        groupDisplayPos.y = (-ti->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-                    }
-
+                    groupDisplayPos.x = (gx[grp] * x->f_zoom_factor + 1.) * ctr.x;
+                    groupDisplayPos.y = (-gy[grp] * x->f_zoom_factor + 1.) * ctr.y;
                     egraphics_line_to(g, groupDisplayPos.x, groupDisplayPos.y);
                     egraphics_stroke(g);
                 }
             }
 
-            if(!it->second->getMute())
+            if(!st->f_smute[i])
             {
                 egraphics_set_color_rgba(g, &sourceColor);
                 egraphics_circle(g, sourceDisplayPos.x, sourceDisplayPos.y, source_size);
@@ -1305,33 +2415,25 @@ void hoa_map_drawGroups(t_hoa_map *x,  t_object *view, t_rect *rect)
         jtl = etext_layout_create();
         egraphics_set_line_width(g, 2.);
 
-		for(Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup() ; it ++)
+        t_hoa_map_store* st = hoa_map_store(x);
+        const double *px, *py, *gx, *gy;
+        hoa_map_store_plane(x->f_coord_view, st->f_sx, st->f_sy, st->f_sz, px, py);
+        hoa_map_store_plane(x->f_coord_view, st->f_gx, st->f_gy, st->f_gz, gx, gy);
+		for(size_t i = 0; i < st->f_groups.size(); i++)
         {
-            if(x->f_coord_view == hoa_sym_view_xy)
-            {
-                sourceDisplayPos.x = (it->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                sourceDisplayPos.y = (-it->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.y;
-            }
-            else if(x->f_coord_view == hoa_sym_view_xz)
-            {
-                sourceDisplayPos.x = (it->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                sourceDisplayPos.y = (-it->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-            }
-            else
-            {
-                sourceDisplayPos.x = (it->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.x;
-                sourceDisplayPos.y = (-it->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-            }
+            Source::Group* grp = st->f_groups[i];
+            sourceDisplayPos.x = (gx[i] * x->f_zoom_factor + 1.) * ctr.x;
+            sourceDisplayPos.y = (-gy[i] * x->f_zoom_factor + 1.) * ctr.y;
 
-            sourceColor.red = it->second->getColor()[0];
-            sourceColor.green = it->second->getColor()[1];
-            sourceColor.blue = it->second->getColor()[2];
-            sourceColor.alpha = it->second->getColor()[3];
+            sourceColor.red = grp->getColor()[0];
+            sourceColor.green = grp->getColor()[1];
+            sourceColor.blue = grp->getColor()[2];
+            sourceColor.alpha = grp->getColor()[3];
 
-            if(it->second->getDescription().c_str()[0])
-                sprintf(description,"%i : %s", (int)it->first, it->second->getDescription().c_str());
+            if(grp->getDescription().c_str()[0])
+                sprintf(description,"%i : %s", (int)st->f_gindices[i], grp->getDescription().c_str());
             else
-                sprintf(description,"%i", (int)it->first);
+                sprintf(description,"%i", (int)st->f_gindices[i]);
 
             textDisplayPos.x = sourceDisplayPos.x - 2. * source_size;
             textDisplayPos.y = sourceDisplayPos.y - source_size - font_size - 1.;
@@ -1340,40 +2442,25 @@ void hoa_map_drawGroups(t_hoa_map *x,  t_object *view, t_rect *rect)
             etext_layout_set(jtl, description, &x->j_box.b_font, textDisplayPos.x, textDisplayPos.y, font_size * 10., font_size * 2., ETEXT_LEFT, ETEXT_JLEFT, ETEXT_NOWRAP);
             etext_layout_draw(jtl, g);
 
-            if (x->f_selected_group && x->f_selected_group->getIndex() == it->first)
+            if (x->f_selected_group == grp)
             {
                 egraphics_set_color_rgba(g, &color_sel);
                 egraphics_circle(g, sourceDisplayPos.x, sourceDisplayPos.y, source_size * 1.5);
                 egraphics_fill(g);
 
-                map<ulong, Source*>& sourcesOfGroup = it->second->getSources();
-                for(Source::source_iterator ti = sourcesOfGroup.begin() ; ti != sourcesOfGroup.end() ; ti ++)
+                for(ulong j = st->f_gsources_offsets[i]; j < st->f_gsources_offsets[i+1]; j++)
                 {
+                    const ulong src = st->f_gsources[j];
                     egraphics_move_to(g, sourceDisplayPos.x, sourceDisplayPos.y);
-
-                    if(x->f_coord_view == hoa_sym_view_xy)
-                    {
-                        groupDisplayPos.x = (ti->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                        groupDisplayPos.y = (-ti->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.y;
-                    }
-                    else if(x->f_coord_view == hoa_sym_view_xz)
-                    {
-                        groupDisplayPos.x = (ti->second->getAbscissa() * x->f_zoom_factor + 1.) * ctr.x;
-                        groupDisplayPos.y = (-ti->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-                    }
-                    else
-                    {
-                        groupDisplayPos.x = (ti->second->getOrdinate() * x->f_zoom_factor + 1.) * ctr.x;
-                        groupDisplayPos.y = (-ti->second->getHeight() * x->f_zoom_factor + 1.) * ctr.y;
-                    }
-
+                    groupDisplayPos.x = (px[src] * x->f_zoom_factor + 1.) * ctr.x;
+                    groupDisplayPos.y = (-py[src] * x->f_zoom_factor + 1.) * ctr.y;
                     egraphics_line_to(g, groupDisplayPos.x, groupDisplayPos.y);
                     egraphics_stroke(g);
                 }
             }
             egraphics_set_color_rgba(g, &sourceColor);
 
-            if(!it->second->getMute())
+            if(!st->f_gmute[i])
             {
                 egraphics_set_color_rgba(g, &sourceColor);
                 egraphics_circle(g, sourceDisplayPos.x, sourceDisplayPos.y, source_size * 1.);
@@ -1514,8 +2601,9 @@ void hoa_map_popup(t_hoa_map *x, t_symbol *s, long itemid)
             case 2:
             {
 				x->f_selected_group->setMute(true);
-				hoa_map_output(x);
-				hoa_map_sendBindedMapUpdate(x, BMAP_OUTPUT);
+				hoa_map_touch(x);
+				hoa_map_output_all(x);
+				hoa_map_sendBindedMapUpdate(x, BMAP_FLUSH);
 				x->f_manager->removeGroupWithSources(x->f_selected_group->getIndex());
 				causeOutput = causeRedraw = causeNotify = 1;
                 break;
@@ -1567,15 +2655,10 @@ void hoa_map_popup(t_hoa_map *x, t_symbol *s, long itemid)
         {
             case 1:
             {
-                ulong index = 1;
-                for (Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource() ; it ++)
-                {
-                    if (it->first != index)
-                        break;
-                    index ++;
-                }
-                x->f_manager->newSource(index);
-;				causeOutput = causeRedraw = causeNotify = 1;
+                const ulong index = hoa_map_store_free_index(hoa_map_store(x)->f_sslots);
+                if(index <= HOA_MAP_MAXINDEX)
+                    x->f_manager->newSource(index);
+				causeOutput = causeRedraw = causeNotify = 1;
                 break;
             }
             case 2:
@@ -1591,12 +2674,13 @@ void hoa_map_popup(t_hoa_map *x, t_symbol *s, long itemid)
 	{
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-		ebox_redraw((t_ebox *)x);
+		hoa_frame_redraw((t_ebox *)x);
 		hoa_map_sendBindedMapUpdate(x, BMAP_REDRAW);
 	}
 
 	if (causeNotify)
 	{
+		hoa_map_touch(x);
 		ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
 		hoa_map_sendBindedMapUpdate(x, BMAP_NOTIFY);
 	}
@@ -1685,157 +2769,73 @@ void hoa_map_mousedrag(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifi
     }
     else if (x->f_selected_group)
     {
+        Source::Group* group = x->f_selected_group;
         if((modifiers & EMOD_SHIFT) && !(modifiers & EMOD_ALT) && !(modifiers & EMOD_CTRL))
         {
             if(x->f_coord_view == hoa_sym_view_xy)
             {
-                x->f_selected_group->setRelativeAzimuth(Math<float>::azimuth(cursor.x, cursor.y));
-            }
-            else if(x->f_coord_view == hoa_sym_view_xz)
-            {
-                if (x->f_mouse_was_dragging)
-                {
-                    t_pt source_display;
-                    double source_radius, source_azimuth, mouse_azimuth, mouse_azimuth_prev;
-                    mouse_azimuth = Math<float>::wrap_twopi(Math<float>::azimuth(cursor.x, cursor.y));
-                    mouse_azimuth_prev = Math<float>::wrap_twopi(Math<float>::azimuth(x->f_cursor_position.x, x->f_cursor_position.y));
-
-                    map<ulong, Source*>& sourcesOfGroup = x->f_selected_group->getSources();
-                    for(Source::source_iterator it = sourcesOfGroup.begin() ; it != sourcesOfGroup.end() ; it ++)
-                    {
-                        source_display.x = it->second->getAbscissa();
-                        source_display.y = it->second->getHeight();
-                        source_radius = Math<float>::radius(source_display.x, source_display.y);
-                        source_azimuth = Math<float>::azimuth(source_display.x, source_display.y);
-                        source_azimuth += mouse_azimuth - mouse_azimuth_prev;
-
-                        it->second->setAbscissa(Math<float>::abscissa(source_radius, source_azimuth));
-                        it->second->setHeight(Math<float>::ordinate(source_radius, source_azimuth));
-                    }
-                }
+                hoa_map_group_turn(x, group, hoa_sym_view_xy, true, 0., Math<float>::azimuth(cursor.x, cursor.y) - group->getAzimuth());
             }
-            else
+            else if (x->f_mouse_was_dragging)
             {
-                if (x->f_mouse_was_dragging)
-                {
-                    t_pt source_display;
-                    double source_radius, source_azimuth, mouse_azimuth, mouse_azimuth_prev;
-                    mouse_azimuth = Math<float>::wrap_twopi(Math<float>::azimuth(cursor.x, cursor.y));
-                    mouse_azimuth_prev = Math<float>::wrap_twopi(Math<float>::azimuth(x->f_cursor_position.x, x->f_cursor_position.y));
-
-                    map<ulong, Source*>& sourcesOfGroup = x->f_selected_group->getSources();
-                    for(Source::source_iterator it = sourcesOfGroup.begin() ; it != sourcesOfGroup.end() ; it ++)
-                    {
-                        source_display.x = it->second->getOrdinate();
-                        source_display.y = it->second->getHeight();
-                        source_radius = Math<float>::radius(source_display.x, source_display.y);
-                        source_azimuth = Math<float>::azimuth(source_display.x, source_display.y);
-                        source_azimuth += mouse_azimuth - mouse_azimuth_prev;
-
-                        it->second->setOrdinate(Math<float>::abscissa(source_radius, source_azimuth));
-                        it->second->setHeight(Math<float>::ordinate(source_radius, source_azimuth));
-                    }
-                }
+                double mouse_azimuth, mouse_azimuth_prev;
+                mouse_azimuth = Math<float>::wrap_twopi(Math<float>::azimuth(cursor.x, cursor.y));
+                mouse_azimuth_prev = Math<float>::wrap_twopi(Math<float>::azimuth(x->f_cursor_position.x, x->f_cursor_position.y));
+                hoa_map_group_turn(x, group, x->f_coord_view, false, 0., mouse_azimuth - mouse_azimuth_prev);
             }
             causeOutput = causeRedraw = causeNotify = 1;
         }
         else if((modifiers & EMOD_ALT) && !(modifiers & EMOD_SHIFT))
         {
-            x->f_selected_group->setRelativeRadius(Math<float>::radius(cursor.x, cursor.y));
+            hoa_map_group_turn(x, group, hoa_sym_view_xy, true, Math<float>::radius(cursor.x, cursor.y) - group->getRadius(), 0.);
             causeOutput = causeRedraw = causeNotify = 1;
         }
         else if((modifiers & EMOD_ALT) && (modifiers & EMOD_SHIFT))
         {
             if(x->f_coord_view == hoa_sym_view_xy)
             {
-                x->f_selected_group->setRelativeRadius(Math<float>::radius(cursor.x, cursor.y));
-                x->f_selected_group->setRelativeAzimuth(Math<float>::azimuth(cursor.x, cursor.y));
+                hoa_map_group_turn(x, group, hoa_sym_view_xy, true, Math<float>::radius(cursor.x, cursor.y) - group->getRadius(), Math<float>::azimuth(cursor.x, cursor.y) - group->getAzimuth());
             }
-            else if(x->f_coord_view == hoa_sym_view_xz)
+            else if (x->f_mouse_was_dragging)
             {
-                if (x->f_mouse_was_dragging)
-                {
-                    t_pt source_display;
-                    double source_radius, source_azimuth, mouse_azimuth, mouse_azimuth_prev, mouse_radius, mouse_radius_prev;
-                    mouse_radius = pd_clip_min(Math<float>::radius(cursor.x, cursor.y), 0);
-                    mouse_radius_prev = pd_clip_min(Math<float>::radius(x->f_cursor_position.x, x->f_cursor_position.y), 0);
-                    mouse_azimuth = Math<float>::wrap_twopi(Math<float>::azimuth(cursor.x, cursor.y));
-                    mouse_azimuth_prev = Math<float>::wrap_twopi(Math<float>::azimuth(x->f_cursor_position.x, x->f_cursor_position.y));
-
-                    map<ulong, Source*>& sourcesOfGroup = x->f_selected_group->getSources();
-                    for(Source::source_iterator it = sourcesOfGroup.begin() ; it != sourcesOfGroup.end() ; it ++)
-                    {
-                        source_display.x = it->second->getAbscissa();
-                        source_display.y = it->second->getHeight();
-                        source_radius = Math<float>::radius(source_display.x, source_display.y);
-                        source_radius += mouse_radius - mouse_radius_prev;
-                        source_azimuth = Math<float>::azimuth(source_display.x, source_display.y);
-                        source_azimuth += mouse_azimuth - mouse_azimuth_prev;
-
-                        it->second->setAbscissa(Math<float>::abscissa(source_radius, source_azimuth));
-                        it->second->setHeight(Math<float>::ordinate(source_radius, source_azimuth));
-                    }
-                }
-            }
-            else
-            {
-                if (x->f_mouse_was_dragging)
-                {
-                    t_pt source_display;
-                    double source_radius, source_azimuth, mouse_azimuth, mouse_azimuth_prev, mouse_radius, mouse_radius_prev;
-                    mouse_radius = pd_clip_min(Math<float>::radius(cursor.x, cursor.y), 0);
-                    mouse_radius_prev = pd_clip_min(Math<float>::radius(x->f_cursor_position.x, x->f_cursor_position.y), 0);
-                    mouse_azimuth = Math<float>::wrap_twopi(Math<float>::azimuth(cursor.x, cursor.y));
-                    mouse_azimuth_prev = Math<float>::wrap_twopi(Math<float>::azimuth(x->f_cursor_position.x, x->f_cursor_position.y));
-
-                    map<ulong, Source*>& sourcesOfGroup = x->f_selected_group->getSources();
-                    for(Source::source_iterator it = sourcesOfGroup.begin() ; it != sourcesOfGroup.end() ; it ++)
-                    {
-                        source_display.x = it->second->getOrdinate();
-                        source_display.y = it->second->getHeight();
-                        source_radius = Math<float>::radius(source_display.x, source_display.y);
-                        source_radius += mouse_radius - mouse_radius_prev;
-                        source_azimuth = Math<float>::azimuth(source_display.x, source_display.y);
-                        source_azimuth += mouse_azimuth - mouse_azimuth_prev;
-
-                        it->second->setOrdinate(Math<float>::abscissa(source_radius, source_azimuth));
-                        it->second->setHeight(Math<float>::ordinate(source_radius, source_azimuth));
-                    }
-                }
+                double mouse_azimuth, mouse_azimuth_prev, mouse_radius, mouse_radius_prev;
+                mouse_radius = pd_clip_min(Math<float>::radius(cursor.x, cursor.y), 0);
+                mouse_radius_prev = pd_clip_min(Math<float>::radius(x->f_cursor_position.x, x->f_cursor_position.y), 0);
+                mouse_azimuth = Math<float>::wrap_twopi(Math<float>::azimuth(cursor.x, cursor.y));
+                mouse_azimuth_prev = Math<float>::wrap_twopi(Math<float>::azimuth(x->f_cursor_position.x, x->f_cursor_position.y));
+                hoa_map_group_turn(x, group, x->f_coord_view, false, mouse_radius - mouse_radius_prev, mouse_azimuth - mouse_azimuth_prev);
             }
             causeOutput = causeRedraw = causeNotify = 1;
         }
         else if((modifiers & EMOD_CTRL) && !(modifiers & EMOD_SHIFT))
         {
             if (x->f_coord_view == hoa_sym_view_xy || x->f_coord_view == hoa_sym_view_xz)
-                x->f_selected_group->setAbscissa(cursor.x);
+                hoa_map_group_move(x, group, cursor.x, group->getOrdinate(), group->getHeight());
             else
-                x->f_selected_group->setOrdinate(cursor.x);
+                hoa_map_group_move(x, group, group->getAbscissa(), cursor.x, group->getHeight());
             causeOutput = causeRedraw = causeNotify = 1;
         }
         else if((modifiers & EMOD_CTRL) && (modifiers & EMOD_SHIFT))
         {
             if (x->f_coord_view == hoa_sym_view_xy)
-                x->f_selected_group->setOrdinate(cursor.y);
+                hoa_map_group_move(x, group, group->getAbscissa(), cursor.y, group->getHeight());
             else
-                x->f_selected_group->setHeight(cursor.y);
+                hoa_map_group_move(x, group, group->getAbscissa(), group->getOrdinate(), cursor.y);
             causeOutput = causeRedraw = causeNotify = 1;
         }
         else
         {
             if(x->f_coord_view == hoa_sym_view_xy)
             {
-                x->f_selected_group->setCoordinatesCartesian(cursor.x, cursor.y);
+                hoa_map_group_move(x, group, cursor.x, cursor.y, group->getHeight());
             }
             else if(x->f_coord_view == hoa_sym_view_xz)
             {
-                x->f_selected_group->setAbscissa(cursor.x);
-                x->f_selected_group->setHeight(cursor.y);
+                hoa_map_group_move(x, group, cursor.x, group->getOrdinate(), cursor.y);
             }
             else
             {
-                x->f_selected_group->setOrdinate(cursor.x);
-                x->f_selected_group->setHeight(cursor.y);
+                hoa_map_group_move(x, group, group->getAbscissa(), cursor.x, cursor.y);
             }
             causeOutput = causeRedraw = causeNotify = 1;
         }
@@ -1845,7 +2845,7 @@ void hoa_map_mousedrag(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifi
 		x->f_rect_selection.width = pt.x - x->f_rect_selection.x;
 		x->f_rect_selection.height = pt.y - x->f_rect_selection.y;
 		ebox_invalidate_layer((t_ebox *)x, gensym("rect_selection_layer"));
-		ebox_redraw((t_ebox *)x);
+		hoa_frame_redraw((t_ebox *)x);
 		causeOutput = causeRedraw = causeNotify = 0;
     }
 
@@ -1855,6 +2855,12 @@ void hoa_map_mousedrag(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifi
 
 	if (causeNotify)
 	{
+        if(x->f_selected_source)
+            hoa_map_refresh(x, x->f_selected_source);
+        else if(x->f_selected_group)
+            hoa_map_refresh_group(x, x->f_selected_group);
+        else
+            hoa_map_touch(x);
 		ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
 		hoa_map_sendBindedMapUpdate(x, BMAP_NOTIFY);
 	}
@@ -1863,7 +2869,7 @@ void hoa_map_mousedrag(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifi
 	{
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-		ebox_redraw((t_ebox *)x);
+		hoa_frame_redraw((t_ebox *)x);
 		hoa_map_sendBindedMapUpdate(x, BMAP_REDRAW);
 	}
 
@@ -1878,21 +2884,14 @@ void hoa_map_mouseup(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifier
 {
 	x->f_mouse_was_dragging = 0;
 
-	t_pt screen_source_coord;
-
 	int causeOutput = 0;
 	int causeRedraw = 0;
 	int causeNotify = 0;
 
-    if(x->f_rect_selection_exist)
+    if(x->f_rect_selection_exist && hoa_map_store_free_index(hoa_map_store(x)->f_gslots) <= HOA_MAP_MAXINDEX)
     {
-        ulong indexOfNewGroup = 1;
-        for (Source::group_iterator it = x->f_manager->getFirstGroup() ; it != x->f_manager->getLastGroup() ; it ++)
-        {
-            if (it->first != indexOfNewGroup)
-                break;
-            indexOfNewGroup ++;
-        }
+        t_hoa_map_store* st = hoa_map_store(x);
+        ulong indexOfNewGroup = hoa_map_store_free_index(st->f_gslots);
 
         double x1 = ((x->f_rect_selection.x / x->rect.width * 2.) - 1.) / x->f_zoom_factor;
         double x2 = (((x->f_rect_selection.x + x->f_rect_selection.width) / x->rect.width * 2.) - 1.) / x->f_zoom_factor;
@@ -1906,29 +2905,14 @@ void hoa_map_mouseup(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifier
             tmp = x->f_manager->createGroup(indexOfNewGroup);
             newGroupCreated = true;
         }
-        for(Source::source_iterator it = x->f_manager->getFirstSource() ; it != x->f_manager->getLastSource() ; it ++)
+        const double *px, *py;
+        vector<ulong> slots;
+        hoa_map_store_plane(x->f_coord_view, st->f_sx, st->f_sy, st->f_sz, px, py);
+        hoa_map_grid_inside(st->f_sgrids+hoa_map_store_grid(x->f_coord_view), px, py, x1, y1, x2, y2, slots);
+        for(size_t i = 0; i < slots.size(); i++)
         {
-            if(x->f_coord_view == hoa_sym_view_xy)
-            {
-                screen_source_coord.x = it->second->getAbscissa();
-                screen_source_coord.y = it->second->getOrdinate();
-            }
-            else if(x->f_coord_view == hoa_sym_view_xz)
-            {
-                screen_source_coord.x = it->second->getAbscissa();
-                screen_source_coord.y = it->second->getHeight();
-            }
-            else
-            {
-                screen_source_coord.x = it->second->getOrdinate();
-                screen_source_coord.y = it->second->getHeight();
-            }
-
-            if(((screen_source_coord.x > x1 && screen_source_coord.x < x2) || (screen_source_coord.x < x1 && screen_source_coord.x > x2)) && ((screen_source_coord.y > y1 && screen_source_coord.y < y2) || (screen_source_coord.y < y1 && screen_source_coord.y > y2)))
-            {
-                tmp->addSource(it->second);
-                causeOutput = causeRedraw = causeNotify = 1;
-            }
+            tmp->addSource(st->f_sources[slots[i]]);
+            causeOutput = causeRedraw = causeNotify = 1;
         }
 
         if (newGroupCreated)
@@ -1943,10 +2927,11 @@ void hoa_map_mouseup(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifier
     x->f_rect_selection_exist = x->f_rect_selection.width = x->f_rect_selection.height = 0;
 
 	ebox_invalidate_layer((t_ebox *)x, hoa_sym_rect_selection_layer);
-	ebox_redraw((t_ebox *)x);
+	hoa_frame_redraw((t_ebox *)x);
 
 	if (causeNotify)
 	{
+		hoa_map_touch(x);
 		ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
 		hoa_map_sendBindedMapUpdate(x, BMAP_NOTIFY);
 	}
@@ -1955,7 +2940,7 @@ void hoa_map_mouseup(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifier
 	{
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
 		ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-		ebox_redraw((t_ebox *)x);
+		hoa_frame_redraw((t_ebox *)x);
 		hoa_map_sendBindedMapUpdate(x, BMAP_REDRAW);
 	}
 
@@ -1976,7 +2961,7 @@ void hoa_map_mousewheel(t_hoa_map *x, t_object *patcherview, t_pt pt, long modif
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
 	}
 }
 
@@ -1991,7 +2976,7 @@ void hoa_map_mousemove(t_hoa_map *x, t_object *patcherview, t_pt pt, long modifi
 
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-    ebox_redraw((t_ebox *)x);
+    hoa_frame_redraw((t_ebox *)x);
 }
 
 t_symbol* hoa_map_stringFormat(const char *s)
@@ -2014,267 +2999,1031 @@ t_symbol* hoa_map_stringFormat(const char *s)
     return gensym(desc);
 }
 
-void hoa_map_preset(t_hoa_map *x, t_binbuf *d)
+static inline bool hoa_map_scene_isfloat(const int ac, t_atom const* av, const ulong i)
 {
-    binbuf_addv(d, (char *)"s", hoa_sym_sources_preset);
-    for(Source::source_iterator it = x->f_manager->getFirstSource(); it != x->f_manager->getLastSource(); it++)
+    return i < ulong(ac) && atom_gettype(av+i) == A_FLOAT;
+}
+
+static inline bool hoa_map_scene_issym(const int ac, t_atom const* av, const ulong i)
+{
+    return i < ulong(ac) && atom_gettype(av+i) == A_SYM;
+}
+
+//! Returns true if the atom is an index between 1 and HOA_MAP_MAXINDEX.
+static inline bool hoa_map_scene_isindex(const int ac, t_atom const* av, const ulong i)
+{
+    return hoa_map_scene_isfloat(ac, av, i) && atom_getfloat(av+i) >= 1 && atom_getfloat(av+i) <= HOA_MAP_MAXINDEX;
+}
+
+//! Returns true if the atoms are the ones the scene was read from.
+static bool hoa_map_scene_equals(t_hoa_map_scene const* scene, const int ac, t_atom const* av)
+{
+    if(size_t(ac) != scene->f_atoms.size())
+        return false;
+    for(int i = 0; i < ac; i++)
     {
-        binbuf_addv(d, (char *)"sffff", hoa_sym_source, (float)it->first,
-                    (float)it->second->getAbscissa(),
-                    (float)it->second->getOrdinate(),
-                    (float)it->second->getHeight());
+        t_atom const* a = &scene->f_atoms[size_t(i)];
+        if(atom_gettype(a) != atom_gettype(av+i))
+            return false;
+        if(atom_gettype(a) == A_FLOAT && atom_getfloat((t_atom *)a) != atom_getfloat((t_atom *)av+i))
+            return false;
+        if(atom_gettype(a) == A_SYM && atom_getsym((t_atom *)a) != atom_getsym((t_atom *)av+i))
+            return false;
+    }
+    return true;
+}
 
-        binbuf_addv(d, (char *)"fffff", (float)it->second->getMute(),
-                    (float)it->second->getColor()[0],
-                    (float)it->second->getColor()[1],
-                    (float)it->second->getColor()[2],
-                    (float)it->second->getColor()[3]);
+#define HOA_MAP_SCENE_VERSION 1
+#define HOA_MAP_SCENE_CHUNK   960
 
-        if(it->second->getDescription().size())
-            binbuf_addv(d, (char *)"s", hoa_map_stringFormat(it->second->getDescription().c_str()));
-        else
-            binbuf_addv(d, (char *)"s", hoa_sym_null);
+//! Appends an unsigned value of 1, 2 or 4 bytes in little endian.
+static inline void hoa_map_bytes_put(vector<unsigned char>& bytes, const unsigned long value, const int size)
+{
+    for(int i = 0; i < size; i++)
+        bytes.push_back((unsigned char)((value >> (8 * i)) & 0xFF));
+}
+
+static inline void hoa_map_bytes_putfloat(vector<unsigned char>& bytes, const float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, 4);
+    hoa_map_bytes_put(bytes, bits, 4);
+}
+
+static inline bool hoa_map_bytes_get(unsigned char const*& p, unsigned char const* end, unsigned long& value, const int size)
+{
+    if(end - p < size)
+        return false;
+    value = 0;
+    for(int i = 0; i < size; i++)
+        value |= (unsigned long)(*p++) << (8 * i);
+    return true;
+}
+
+static inline bool hoa_map_bytes_getfloat(unsigned char const*& p, unsigned char const* end, float& value)
+{
+    unsigned long bits;
+    if(!hoa_map_bytes_get(p, end, bits, 4))
+        return false;
+    const unsigned int bits32 = (unsigned int)bits;
+    memcpy(&value, &bits32, 4);
+    return true;
+}
+
+static void hoa_map_bytes_putdescription(vector<unsigned char>& bytes, t_symbol* description)
+{
+    const size_t size = description ? min(strlen(description->s_name), size_t(0xFFFF)) : 0;
+    hoa_map_bytes_put(bytes, size, 2);
+    if(size)
+        bytes.insert(bytes.end(), description->s_name, description->s_name + size);
+}
+
+static bool hoa_map_bytes_getdescription(unsigned char const*& p, unsigned char const* end, t_symbol*& description)
+{
+    unsigned long size;
+    if(!hoa_map_bytes_get(p, end, size, 2) || (unsigned long)(end - p) < size)
+        return false;
+    description = size ? gensym(string((char const*)p, size_t(size)).c_str()) : NULL;
+    p += size;
+    return true;
+}
+
+//! Writes a scene in the compact binary format: a header "HOAM", the version, the number of sources and of groups, then the records of the sources and of the groups.
+/** A source is its index, its coordinates, its flags (1 mute, 2 colored), its color if any and its description. A group is its index, the number and the indices of its sources, its flags, its color if any and its description. The values are little endian, the floats 32 bits.
+ */
+static void hoa_map_scene_encode(t_hoa_map_scene const* scene, vector<unsigned char>& bytes)
+{
+    const size_t nsources = scene->f_sindices.size();
+    const size_t ngroups  = scene->f_gindices.size();
+    bytes.clear();
+    bytes.reserve(16 + nsources * 40 + ngroups * 32 + scene->f_gsources.size() * 4);
+    bytes.push_back('H'); bytes.push_back('O'); bytes.push_back('A'); bytes.push_back('M');
+    hoa_map_bytes_put(bytes, HOA_MAP_SCENE_VERSION, 4);
+    hoa_map_bytes_put(bytes, nsources, 4);
+    hoa_map_bytes_put(bytes, ngroups, 4);
+    for(size_t i = 0; i < nsources; i++)
+    {
+        hoa_map_bytes_put(bytes, scene->f_sindices[i], 4);
+        hoa_map_bytes_putfloat(bytes, scene->f_sx[i]);
+        hoa_map_bytes_putfloat(bytes, scene->f_sy[i]);
+        hoa_map_bytes_putfloat(bytes, scene->f_sz[i]);
+        hoa_map_bytes_put(bytes, (scene->f_smute[i] ? 1 : 0) | (scene->f_scolored[i] ? 2 : 0), 1);
+        if(scene->f_scolored[i])
+        {
+            for(size_t j = 0; j < 4; j++)
+                hoa_map_bytes_putfloat(bytes, scene->f_scolors[i*4+j]);
+        }
+        hoa_map_bytes_putdescription(bytes, scene->f_sdescriptions[i]);
     }
+    for(size_t i = 0; i < ngroups; i++)
+    {
+        hoa_map_bytes_put(bytes, scene->f_gindices[i], 4);
+        hoa_map_bytes_put(bytes, scene->f_gsources_offsets[i+1] - scene->f_gsources_offsets[i], 4);
+        for(ulong j = scene->f_gsources_offsets[i]; j < scene->f_gsources_offsets[i+1]; j++)
+            hoa_map_bytes_put(bytes, scene->f_gsources[j], 4);
+        hoa_map_bytes_put(bytes, scene->f_gcolored[i] ? 2 : 0, 1);
+        if(scene->f_gcolored[i])
+        {
+            for(size_t j = 0; j < 4; j++)
+                hoa_map_bytes_putfloat(bytes, scene->f_gcolors[i*4+j]);
+        }
+        hoa_map_bytes_putdescription(bytes, scene->f_gdescriptions[i]);
+    }
+}
 
-    for(Source::group_iterator it = x->f_manager->getFirstGroup(); it != x->f_manager->getLastGroup(); it++)
+//! Appends the sources and the groups of a scene in the compact binary format, returns false if the data are invalid.
+static bool hoa_map_scene_decode(t_hoa_map_scene* scene, unsigned char const* p, const size_t size)
+{
+    unsigned char const* end = p + size;
+    unsigned long version, nsources, ngroups, value;
+    if(size < 16 || p[0] != 'H' || p[1] != 'O' || p[2] != 'A' || p[3] != 'M')
+        return false;
+    p += 4;
+    if(!hoa_map_bytes_get(p, end, version, 4) || version != HOA_MAP_SCENE_VERSION
+       || !hoa_map_bytes_get(p, end, nsources, 4) || !hoa_map_bytes_get(p, end, ngroups, 4))
+        return false;
+
+    for(unsigned long i = 0; i < nsources; i++)
+    {
+        unsigned long index, flags;
+        float x, y, z, color[4] = {0.f, 0.f, 0.f, 0.f};
+        t_symbol* description;
+        if(!hoa_map_bytes_get(p, end, index, 4) || !index || index > HOA_MAP_MAXINDEX || !hoa_map_bytes_getfloat(p, end, x)
+           || !hoa_map_bytes_getfloat(p, end, y) || !hoa_map_bytes_getfloat(p, end, z)
+           || !hoa_map_bytes_get(p, end, flags, 1))
+            return false;
+        for(int j = 0; j < 4 && (flags & 2); j++)
+        {
+            if(!hoa_map_bytes_getfloat(p, end, color[j]))
+                return false;
+        }
+        if(!hoa_map_bytes_getdescription(p, end, description))
+            return false;
+
+        scene->f_sindices.push_back(index);
+        scene->f_sx.push_back(x); scene->f_sy.push_back(y); scene->f_sz.push_back(z);
+        scene->f_smute.push_back(char(flags & 1));
+        scene->f_scolored.push_back(char((flags & 2) != 0));
+        scene->f_scolors.insert(scene->f_scolors.end(), color, color + 4);
+        scene->f_sdescriptions.push_back(description);
+    }
+    for(unsigned long i = 0; i < ngroups; i++)
     {
-        binbuf_addv(d, (char *)"sf", hoa_sym_group, (float)it->first);
-        binbuf_addv(d, (char *)"f", (float)it->second->getNumberOfSources());
+        unsigned long index, count, flags;
+        float color[4] = {0.f, 0.f, 0.f, 0.f};
+        t_symbol* description;
+        if(!hoa_map_bytes_get(p, end, index, 4) || !index || index > HOA_MAP_MAXINDEX
+           || !hoa_map_bytes_get(p, end, count, 4) || count > size_t(end - p) / 4)
+            return false;
+        unsigned char const* sources = p;
+        p += count * 4;
+        if(!hoa_map_bytes_get(p, end, flags, 1))
+            return false;
+        for(int j = 0; j < 4 && (flags & 2); j++)
+        {
+            if(!hoa_map_bytes_getfloat(p, end, color[j]))
+                return false;
+        }
+        if(!hoa_map_bytes_getdescription(p, end, description))
+            return false;
 
-        map<ulong, Source*>& sourcesOfGroup = it->second->getSources();
-        for(Source::source_iterator ti = sourcesOfGroup.begin() ; ti != sourcesOfGroup.end() ; ti++)
+        for(unsigned long j = 0; j < count; j++)
         {
-            binbuf_addv(d, (char *)"f", (float)ti->first);
+            hoa_map_bytes_get(sources, end, value, 4);
+            if(!value || value > HOA_MAP_MAXINDEX)
+                return false;
+            scene->f_gsources.push_back(value);
         }
+        scene->f_gindices.push_back(index);
+        scene->f_gsources_offsets.push_back(scene->f_gsources.size());
+        scene->f_gcolored.push_back(char((flags & 2) != 0));
+        scene->f_gcolors.insert(scene->f_gcolors.end(), color, color + 4);
+        scene->f_gdescriptions.push_back(description);
+    }
+    return true;
+}
 
-        binbuf_addv(d, (char *)"ffff",
-                    (float)it->second->getColor()[0],
-                    (float)it->second->getColor()[1],
-                    (float)it->second->getColor()[2],
-                    (float)it->second->getColor()[3]);
+static const char hoa_map_base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-        if(it->second->getDescription().size())
-            binbuf_addv(d, (char *)"s", hoa_map_stringFormat(it->second->getDescription().c_str()));
-        else
-            binbuf_addv(d, (char *)"s", hoa_sym_null);
+//! Appends the binary scene to a binbuf as symbols of base64, each one starts with a "b" so Pd never reads it as a number.
+static void hoa_map_scene_addblob(t_binbuf* d, vector<unsigned char> const& bytes)
+{
+    string chunk("b");
+    for(size_t i = 0; i < bytes.size(); i += 3)
+    {
+        const unsigned long n = (unsigned long)bytes[i] << 16
+                              | (i + 1 < bytes.size() ? (unsigned long)bytes[i+1] << 8 : 0)
+                              | (i + 2 < bytes.size() ? (unsigned long)bytes[i+2] : 0);
+        chunk += hoa_map_base64[(n >> 18) & 63];
+        chunk += hoa_map_base64[(n >> 12) & 63];
+        chunk += i + 1 < bytes.size() ? hoa_map_base64[(n >> 6) & 63] : '=';
+        chunk += i + 2 < bytes.size() ? hoa_map_base64[n & 63] : '=';
+        if(chunk.size() > HOA_MAP_SCENE_CHUNK)
+        {
+            binbuf_addv(d, (char *)"s", gensym(chunk.c_str()));
+            chunk = "b";
+        }
     }
+    if(chunk.size() > 1)
+        binbuf_addv(d, (char *)"s", gensym(chunk.c_str()));
 }
 
-void hoa_map_sourcesPreset(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
+//! Reads the symbols of base64 that follow the symbol "scene", returns the number of atoms read.
+static ulong hoa_map_scene_getblob(const int ac, t_atom const* av, vector<unsigned char>& bytes)
 {
-    ulong index;
-    ulong nsources;
-    if(ac && av)
+    ulong i = 0;
+    unsigned long n = 0;
+    int bits = 0;
+    bytes.clear();
+    while(i < ulong(ac) && atom_gettype(av+i) == A_SYM && atom_getsym((t_atom *)av+i)->s_name[0] == 'b')
     {
-        x->f_manager->clear();
-        ulong i = 0;
-        while(i < ulong(ac))
+        for(char const* c = atom_getsym((t_atom *)av+i)->s_name + 1; *c && *c != '='; c++)
         {
-            if(atom_gettype(av+i) == A_SYM && atom_getsym(av+i) == hoa_sym_source
-               && atom_gettype(av+i+1) == A_FLOAT
-               && atom_gettype(av+i+2) == A_FLOAT
-               && atom_gettype(av+i+3) == A_FLOAT
-               && atom_gettype(av+i+4) == A_FLOAT)
+            char const* pos = strchr(hoa_map_base64, *c);
+            if(!pos)
+                continue;
+            n = (n << 6) | (unsigned long)(pos - hoa_map_base64);
+            bits += 6;
+            if(bits >= 8)
             {
-                index = ulong(atom_getlong(av+i+1));
-                Source* tmp = x->f_manager->newSource(index);
-                tmp->setCoordinatesCartesian(atom_getfloat(av+i+2), atom_getfloat(av+i+3), atom_getfloat(av+i+4));
-
-                if(atom_gettype(av+i+5) == A_FLOAT && atom_getfloat(av+i+5) == 0)
-                    tmp->setMute(false);
-                else
-                    tmp->setMute(true);
-
-                if(atom_gettype(av+i+6) == A_FLOAT
-                   && atom_gettype(av+i+7) == A_FLOAT
-                   && atom_gettype(av+i+8) == A_FLOAT
-                   && atom_gettype(av+i+9) == A_FLOAT)
-                    tmp->setColor(atom_getfloat(av+i+6), atom_getfloat(av+i+7), atom_getfloat(av+i+8), atom_getfloat(av+i+9));
-
-                if(atom_gettype(av+i+10) == A_SYM && atom_getsym(av+i+10) != gensym("(null)"))
-                    tmp->setDescription(hoa_map_stringFormat(atom_getsym(av+i+10)->s_name)->s_name);
-                else
-                    tmp->setDescription("");
+                bits -= 8;
+                bytes.push_back((unsigned char)((n >> bits) & 0xFF));
+            }
+        }
+        i++;
+    }
+    return i;
+}
 
+//! Reads the sources and the groups of a preset, an element is "source index abscissa ordinate height mute r g b a description", "group index size sources r g b a description" or "scene" followed by a compact binary scene in base64.
+static void hoa_map_scene_parse(t_hoa_map_scene* scene, const int ac, t_atom const* av)
+{
+    scene->f_atoms.assign(av, av + ac);
+    scene->f_sindices.clear(); scene->f_sx.clear(); scene->f_sy.clear(); scene->f_sz.clear();
+    scene->f_smute.clear(); scene->f_scolored.clear(); scene->f_scolors.clear(); scene->f_sdescriptions.clear();
+    scene->f_gindices.clear(); scene->f_gsources_offsets.assign(1, 0); scene->f_gsources.clear();
+    scene->f_gcolored.clear(); scene->f_gcolors.clear(); scene->f_gdescriptions.clear();
+
+    t_atom* atoms = (t_atom *)av;
+    ulong i = 0;
+    while(i < ulong(ac))
+    {
+        if(atom_gettype(atoms+i) == A_SYM && atom_getsym(atoms+i) == hoa_sym_source
+           && hoa_map_scene_isfloat(ac, av, i+1)
+           && hoa_map_scene_isfloat(ac, av, i+2)
+           && hoa_map_scene_isfloat(ac, av, i+3)
+           && hoa_map_scene_isfloat(ac, av, i+4))
+        {
+            if(!hoa_map_scene_isindex(ac, av, i+1))
+            {
                 i += 11;
+                continue;
+            }
+            scene->f_sindices.push_back(ulong(atom_getlong(atoms+i+1)));
+            scene->f_sx.push_back(atom_getfloat(atoms+i+2));
+            scene->f_sy.push_back(atom_getfloat(atoms+i+3));
+            scene->f_sz.push_back(atom_getfloat(atoms+i+4));
+            scene->f_smute.push_back(char(!(hoa_map_scene_isfloat(ac, av, i+5) && atom_getfloat(atoms+i+5) == 0)));
+
+            const bool colored = hoa_map_scene_isfloat(ac, av, i+6) && hoa_map_scene_isfloat(ac, av, i+7)
+                              && hoa_map_scene_isfloat(ac, av, i+8) && hoa_map_scene_isfloat(ac, av, i+9);
+            scene->f_scolored.push_back(char(colored));
+            for(ulong j = 6; j < 10; j++)
+                scene->f_scolors.push_back(colored ? atom_getfloat(atoms+i+j) : 0.f);
+
+            if(hoa_map_scene_issym(ac, av, i+10) && atom_getsym(atoms+i+10) != hoa_sym_null)
+                scene->f_sdescriptions.push_back(hoa_map_stringFormat(atom_getsym(atoms+i+10)->s_name));
+            else
+                scene->f_sdescriptions.push_back(NULL);
+
+            i += 11;
+        }
+        else if(atom_gettype(atoms+i) == A_SYM && atom_getsym(atoms+i) == hoa_sym_group
+           && hoa_map_scene_isfloat(ac, av, i+1)
+           && hoa_map_scene_isfloat(ac, av, i+2))
+        {
+            const t_float count = atom_getfloat(atoms+i+2);
+            if(count < 0 || count > t_float(ulong(ac) - i - 3) || count > HOA_MAP_MAXINDEX)
+            {
+                pd_error(NULL, "hoa.map: invalid number of sources %g in a group.", count);
+                i++;
+                continue;
             }
-            else if(atom_gettype(av+i) == A_SYM && atom_getsym(av+i) == hoa_sym_group
-               && atom_gettype(av+i+1) == A_FLOAT
-               && atom_gettype(av+i+2) == A_FLOAT)
+            const ulong nsources = ulong(count);
+            if(!hoa_map_scene_isindex(ac, av, i+1))
             {
-                index = ulong(atom_getlong(av+i+1));
-                nsources = ulong(atom_getlong(av+i+2));
+                i += (7+nsources);
+                continue;
+            }
+            scene->f_gindices.push_back(ulong(atom_getlong(atoms+i+1)));
+            for(ulong j = 0; j < nsources; j++)
+            {
+                if(hoa_map_scene_isindex(ac, av, i+3+j))
+                    scene->f_gsources.push_back(ulong(atom_getlong(atoms+i+3+j)));
+            }
+            scene->f_gsources_offsets.push_back(scene->f_gsources.size());
 
-                bool newGroupCreated = false;
-                Source::Group* tmp = x->f_manager->getGroup(index);
-                if (!tmp)
-                {
-                    tmp = x->f_manager->createGroup(index);
-                    newGroupCreated = true;
-                }
+            const bool colored = hoa_map_scene_isfloat(ac, av, i+3+nsources) && hoa_map_scene_isfloat(ac, av, i+4+nsources)
+                              && hoa_map_scene_isfloat(ac, av, i+5+nsources) && hoa_map_scene_isfloat(ac, av, i+6+nsources);
+            scene->f_gcolored.push_back(char(colored));
+            for(ulong j = 3; j < 7; j++)
+                scene->f_gcolors.push_back(colored ? atom_getfloat(atoms+i+j+nsources) : 0.f);
 
-                for(ulong j = 0; j < nsources; j++)
-                {
-                    if(ulong(ac) > i+3+j && atom_gettype(av+i+3+j) == A_FLOAT)
-                    {
-                        Source* src = x->f_manager->getSource(ulong(atom_getlong(av+i+3+j)));
-                        if (src)
-                            tmp->addSource(src);
-                    }
-                }
+            if(hoa_map_scene_issym(ac, av, i+7+nsources) && atom_getsym(atoms+i+7+nsources) != hoa_sym_null)
+                scene->f_gdescriptions.push_back(hoa_map_stringFormat(atom_getsym(atoms+i+7+nsources)->s_name));
+            else
+                scene->f_gdescriptions.push_back(NULL);
+
+            i += (7+nsources);
+        }
+        else if(atom_gettype(atoms+i) == A_SYM && atom_getsym(atoms+i) == hoa_sym_scene)
+        {
+            vector<unsigned char> bytes;
+            const ulong size = hoa_map_scene_getblob(int(ac - (i + 1)), av+i+1, bytes);
+            if(!hoa_map_scene_decode(scene, bytes.data(), bytes.size()))
+                pd_error(NULL, "hoa.map: invalid compact scene.");
+            i += 1 + size;
+        }
+        else
+            i ++;
+    }
+}
 
-                if(ulong(ac) > i+6+nsources
-                   && atom_gettype(av+i+3+nsources) == A_FLOAT
-                   && atom_gettype(av+i+4+nsources) == A_FLOAT
-                   && atom_gettype(av+i+5+nsources) == A_FLOAT
-                   && atom_gettype(av+i+6+nsources) == A_FLOAT)
-                    tmp->setColor(atom_getfloat(av+i+3+nsources), atom_getfloat(av+i+4+nsources), atom_getfloat(av+i+5+nsources), atom_getfloat(av+i+6+nsources));
+static void hoa_map_interp_pair(t_hoa_map_interp* it)
+{
+    t_hoa_map_scene const* from = &it->f_from;
+    t_hoa_map_scene const* to   = &it->f_to;
+    vector<long>& slots         = it->f_slots;
+    for(size_t i = 0; i < to->f_sindices.size(); i++)
+    {
+        const ulong index = to->f_sindices[i];
+        if(index > HOA_MAP_MAXINDEX)
+            continue;
+        if(index >= slots.size())
+            slots.resize(index + 1, -1);
+        if(slots[index] < 0)
+            slots[index] = long(i);
+    }
 
-                if(ulong(ac) > i+7+nsources && atom_gettype(av+i+7+nsources) == A_SYM && atom_getsym(av+i+7+nsources) != hoa_sym_null)
-                    tmp->setDescription(hoa_map_stringFormat(atom_getsym(av+i+7+nsources)->s_name)->s_name);
-                else
-                    tmp->setDescription("");
+    const size_t nsources = from->f_sindices.size();
+    it->f_tx.resize(nsources); it->f_ty.resize(nsources); it->f_tz.resize(nsources);
+    for(size_t i = 0; i < nsources; i++)
+    {
+        const long slot = hoa_map_store_slot(slots, from->f_sindices[i]);
+        it->f_tx[i] = slot >= 0 ? to->f_sx[slot] : from->f_sx[i];
+        it->f_ty[i] = slot >= 0 ? to->f_sy[slot] : from->f_sy[i];
+        it->f_tz[i] = slot >= 0 ? to->f_sz[slot] : from->f_sz[i];
+    }
+    it->f_x.resize(nsources); it->f_y.resize(nsources); it->f_z.resize(nsources);
 
-                if (newGroupCreated)
-                {
-                    if (!x->f_manager->addGroup(tmp))
-                    {
-                        delete tmp;
-                    }
-                }
-                i += (7+nsources);
+    for(size_t i = 0; i < to->f_sindices.size(); i++)
+    {
+        if(to->f_sindices[i] < slots.size())
+            slots[to->f_sindices[i]] = -1;
+    }
+}
+
+//! Replaces the sources and the groups of the manager by the ones of a scene.
+static void hoa_map_scene_apply(t_hoa_map *x, t_hoa_map_scene const* scene)
+{
+    x->f_manager->clear();
+    for(size_t i = 0; i < scene->f_sindices.size(); i++)
+    {
+        Source* tmp = x->f_manager->newSource(scene->f_sindices[i]);
+        tmp->setCoordinatesCartesian(scene->f_sx[i], scene->f_sy[i], scene->f_sz[i]);
+        tmp->setMute(scene->f_smute[i]);
+        if(scene->f_scolored[i])
+            tmp->setColor(scene->f_scolors[i*4], scene->f_scolors[i*4+1], scene->f_scolors[i*4+2], scene->f_scolors[i*4+3]);
+        tmp->setDescription(scene->f_sdescriptions[i] ? scene->f_sdescriptions[i]->s_name : "");
+    }
+
+    for(size_t i = 0; i < scene->f_gindices.size(); i++)
+    {
+        bool newGroupCreated = false;
+        Source::Group* tmp = x->f_manager->getGroup(scene->f_gindices[i]);
+        if (!tmp)
+        {
+            tmp = x->f_manager->createGroup(scene->f_gindices[i]);
+            newGroupCreated = true;
+        }
+
+        for(ulong j = scene->f_gsources_offsets[i]; j < scene->f_gsources_offsets[i+1]; j++)
+        {
+            Source* src = x->f_manager->getSource(scene->f_gsources[j]);
+            if (src)
+                tmp->addSource(src);
+        }
+
+        if(scene->f_gcolored[i])
+            tmp->setColor(scene->f_gcolors[i*4], scene->f_gcolors[i*4+1], scene->f_gcolors[i*4+2], scene->f_gcolors[i*4+3]);
+        tmp->setDescription(scene->f_gdescriptions[i] ? scene->f_gdescriptions[i]->s_name : "");
+
+        if (newGroupCreated)
+        {
+            if (!x->f_manager->addGroup(tmp))
+            {
+                delete tmp;
             }
-            else
-                i ++;
         }
     }
+}
+
+//! Copies the sources and the groups of the store in a scene.
+static void hoa_map_scene_store(t_hoa_map *x, t_hoa_map_scene* scene)
+{
+    t_hoa_map_store* st = hoa_map_store(x);
+    const size_t nsources = st->f_sources.size();
+    const size_t ngroups  = st->f_groups.size();
+    scene->f_atoms.clear();
+    scene->f_sindices = st->f_sindices;
+    scene->f_sx.assign(st->f_sx.begin(), st->f_sx.end());
+    scene->f_sy.assign(st->f_sy.begin(), st->f_sy.end());
+    scene->f_sz.assign(st->f_sz.begin(), st->f_sz.end());
+    scene->f_smute = st->f_smute;
+    scene->f_scolored.assign(nsources, 1);
+    scene->f_scolors.resize(nsources * 4);
+    scene->f_sdescriptions.resize(nsources);
+    for(size_t i = 0; i < nsources; i++)
+    {
+        Source* src = st->f_sources[i];
+        for(size_t j = 0; j < 4; j++)
+            scene->f_scolors[i*4+j] = float(src->getColor()[j]);
+        scene->f_sdescriptions[i] = src->getDescription().size() ? hoa_map_stringFormat(src->getDescription().c_str()) : NULL;
+    }
+
+    scene->f_gindices = st->f_gindices;
+    scene->f_gsources_offsets = st->f_gsources_offsets;
+    scene->f_gsources.resize(st->f_gsources.size());
+    for(size_t i = 0; i < st->f_gsources.size(); i++)
+        scene->f_gsources[i] = st->f_sindices[st->f_gsources[i]];
+    scene->f_gcolored.assign(ngroups, 1);
+    scene->f_gcolors.resize(ngroups * 4);
+    scene->f_gdescriptions.resize(ngroups);
+    for(size_t i = 0; i < ngroups; i++)
+    {
+        Source::Group* grp = st->f_groups[i];
+        for(size_t j = 0; j < 4; j++)
+            scene->f_gcolors[i*4+j] = float(grp->getColor()[j]);
+        scene->f_gdescriptions[i] = grp->getDescription().size() ? hoa_map_stringFormat(grp->getDescription().c_str()) : NULL;
+    }
+}
 
+//! Replaces the scene of the map and notifies, redraws and outputs all the maps.
+static void hoa_map_scene_load(t_hoa_map *x, t_hoa_map_scene const* scene)
+{
+    if(scene)
+    {
+        hoa_map_scene_apply(x, scene);
+    }
+
+    hoa_map_touch(x);
     ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-    ebox_redraw((t_ebox *)x);
+    hoa_frame_redraw((t_ebox *)x);
     hoa_map_output(x);
     hoa_map_sendBindedMapUpdate(x, BMAP_REDRAW | BMAP_OUTPUT | BMAP_NOTIFY);
 }
 
+void hoa_map_preset(t_hoa_map *x, t_binbuf *d)
+{
+    t_hoa_map_store* st = hoa_map_store(x);
+    binbuf_addv(d, (char *)"s", hoa_sym_sources_preset);
+    if(x->f_compact)
+    {
+        t_hoa_map_scene scene;
+        vector<unsigned char> bytes;
+        hoa_map_scene_store(x, &scene);
+        hoa_map_scene_encode(&scene, bytes);
+        binbuf_addv(d, (char *)"s", hoa_sym_scene);
+        hoa_map_scene_addblob(d, bytes);
+        return;
+    }
+    for(size_t i = 0; i < st->f_sources.size(); i++)
+    {
+        Source* src = st->f_sources[i];
+        binbuf_addv(d, (char *)"sffff", hoa_sym_source, (float)st->f_sindices[i],
+                    (float)st->f_sx[i],
+                    (float)st->f_sy[i],
+                    (float)st->f_sz[i]);
+
+        binbuf_addv(d, (char *)"fffff", (float)st->f_smute[i],
+                    (float)src->getColor()[0],
+                    (float)src->getColor()[1],
+                    (float)src->getColor()[2],
+                    (float)src->getColor()[3]);
+
+        if(src->getDescription().size())
+            binbuf_addv(d, (char *)"s", hoa_map_stringFormat(src->getDescription().c_str()));
+        else
+            binbuf_addv(d, (char *)"s", hoa_sym_null);
+    }
+
+    for(size_t i = 0; i < st->f_groups.size(); i++)
+    {
+        Source::Group* grp = st->f_groups[i];
+        binbuf_addv(d, (char *)"sf", hoa_sym_group, (float)st->f_gindices[i]);
+        binbuf_addv(d, (char *)"f", (float)(st->f_gsources_offsets[i+1] - st->f_gsources_offsets[i]));
+
+        for(ulong j = st->f_gsources_offsets[i]; j < st->f_gsources_offsets[i+1]; j++)
+        {
+            binbuf_addv(d, (char *)"f", (float)st->f_sindices[st->f_gsources[j]]);
+        }
+
+        binbuf_addv(d, (char *)"ffff",
+                    (float)grp->getColor()[0],
+                    (float)grp->getColor()[1],
+                    (float)grp->getColor()[2],
+                    (float)grp->getColor()[3]);
+
+        if(grp->getDescription().size())
+            binbuf_addv(d, (char *)"s", hoa_map_stringFormat(grp->getDescription().c_str()));
+        else
+            binbuf_addv(d, (char *)"s", hoa_sym_null);
+    }
+}
+
+void hoa_map_sourcesPreset(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
+{
+    if(ac && av)
+    {
+        t_hoa_map_scene scene;
+        hoa_map_scene_parse(&scene, ac, av);
+        hoa_map_scene_load(x, &scene);
+    }
+    else
+    {
+        hoa_map_scene_load(x, NULL);
+    }
+}
+
+//! Writes the scene in a file in the compact binary format, the path is relative to the patch.
+void hoa_map_write(t_hoa_map *x, t_symbol *s)
+{
+    char path[MAXPDSTRING];
+    t_hoa_map_scene scene;
+    vector<unsigned char> bytes;
+    hoa_map_scene_store(x, &scene);
+    hoa_map_scene_encode(&scene, bytes);
+
+    canvas_makefilename(eobj_getcanvas(x), s->s_name, path, MAXPDSTRING);
+    FILE* file = sys_fopen(path, "wb");
+    if(!file)
+    {
+        pd_error(x, "hoa.map: can't create %s.", path);
+        return;
+    }
+    if(fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+    {
+        pd_error(x, "hoa.map: error while writing %s.", path);
+    }
+    sys_fclose(file);
+}
+
+//! Reads a scene from a file in the compact binary format, the file is read in one block and the scene is applied at once.
+void hoa_map_read(t_hoa_map *x, t_symbol *s)
+{
+    char path[MAXPDSTRING];
+    canvas_makefilename(eobj_getcanvas(x), s->s_name, path, MAXPDSTRING);
+    FILE* file = sys_fopen(path, "rb");
+    if(!file)
+    {
+        pd_error(x, "hoa.map: can't open %s.", path);
+        return;
+    }
+
+    vector<unsigned char> bytes;
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if(size > 0)
+    {
+        bytes.resize(size_t(size));
+        bytes.resize(fread(bytes.data(), 1, bytes.size(), file));
+    }
+    sys_fclose(file);
+
+    t_hoa_map_scene scene;
+    scene.f_gsources_offsets.assign(1, 0);
+    if(!hoa_map_scene_decode(&scene, bytes.data(), bytes.size()))
+    {
+        pd_error(x, "hoa.map: %s is not a valid scene.", path);
+        return;
+    }
+    hoa_map_scene_load(x, &scene);
+}
+
+//! Moves the sources between two presets, the presets are parsed once and the scene is only rebuilt if it changed since the last step.
 void hoa_map_interpolate(t_hoa_map *x, int ac, t_atom *av, short ac2, t_atom* av2, t_atom ratio)
 {
-    ulong index;
-    ulong nsources;
-    float exist2;
-    float theta = atom_getfloat(&ratio);
+    const float theta = atom_getfloat(&ratio);
+    t_hoa_map_interp* it = x->f_interp;
 
     if(ac && av)
     {
-        x->f_manager->clear();
-        ulong i = 0;
-        while(i < ulong(ac))
+        bool paired = true;
+        if(!hoa_map_scene_equals(&it->f_from, ac, av))
         {
-            if(atom_gettype(av+i) == A_SYM && atom_getsym(av+i) == hoa_sym_source
-               && atom_gettype(av+i+1) == A_FLOAT
-               && atom_gettype(av+i+2) == A_FLOAT
-               && atom_gettype(av+i+3) == A_FLOAT
-               && atom_gettype(av+i+4) == A_FLOAT)
+            hoa_map_scene_parse(&it->f_from, ac, av);
+            it->f_version = 0;
+            paired = false;
+        }
+        if(!hoa_map_scene_equals(&it->f_to, ac2, av2))
+        {
+            hoa_map_scene_parse(&it->f_to, ac2, av2);
+            paired = false;
+        }
+        if(!paired)
+        {
+            hoa_map_interp_pair(it);
+        }
+
+        const size_t nsources = it->f_from.f_sindices.size();
+        float const* fx = it->f_from.f_sx.data();
+        float const* fy = it->f_from.f_sy.data();
+        float const* fz = it->f_from.f_sz.data();
+        float const* tx = it->f_tx.data();
+        float const* ty = it->f_ty.data();
+        float const* tz = it->f_tz.data();
+        float* ix = it->f_x.data();
+        float* iy = it->f_y.data();
+        float* iz = it->f_z.data();
+        for(size_t i = 0; i < nsources; i++)
+        {
+            ix[i] = fx[i] * (1.f - theta) + tx[i] * theta;
+            iy[i] = fy[i] * (1.f - theta) + ty[i] * theta;
+            iz[i] = fz[i] * (1.f - theta) + tz[i] * theta;
+        }
+
+        if(it->f_version == x->f_store->f_version)
+        {
+            for(size_t i = 0; i < nsources; i++)
             {
-                index = ulong(atom_getlong(av+i+1));
-                exist2 = 0;
-                Source* tmp = x->f_manager->newSource(index);
-                for(int j = 0; j < ac2; j++)
+                if(it->f_sources[i] && (ix[i] != it->f_lx[i] || iy[i] != it->f_ly[i] || iz[i] != it->f_lz[i]))
                 {
-                    if(ac2 > j+10)
-                    {
-                        if(atom_gettype(av2+j) == A_SYM && atom_getsym(av2+j) == hoa_sym_source
-                           && atom_gettype(av2+j+1) == A_FLOAT
-                           && atom_gettype(av2+j+2) == A_FLOAT
-                           && atom_gettype(av2+j+3) == A_FLOAT
-                           && atom_gettype(av2+j+4) == A_FLOAT
-                           && index == ulong(atom_getlong(av2+(ulong)j+1)))
-                        {
-                            exist2 = 1;
-                            float abscissa = atom_getfloat(av+i+2) * (1.f - theta) + atom_getfloat(av2+j+2) * theta;
-                            float ordinate = atom_getfloat(av+i+3) * (1.f - theta) + atom_getfloat(av2+j+3) * theta;
-                            float height = atom_getfloat(av+i+4) * (1.f - theta) + atom_getfloat(av2+j+4) * theta;
-                            tmp->setCoordinatesCartesian(abscissa, ordinate, height);
-                            break;
-                        }
-                    }
+                    it->f_lx[i] = ix[i]; it->f_ly[i] = iy[i]; it->f_lz[i] = iz[i];
+                    it->f_sources[i]->setCoordinatesCartesian(ix[i], iy[i], iz[i]);
+                    hoa_map_refresh(x, it->f_sources[i]);
                 }
-                if(!exist2)
-                {
-                    tmp->setCoordinatesCartesian(atom_getfloat(av+i+2), atom_getfloat(av+i+3), atom_getfloat(av+i+4));
-                }
-                if(atom_gettype(av+i+5) == A_FLOAT && atom_getfloat(av+i+5) == 0)
-                    tmp->setMute(false);
-                else
-                    tmp->setMute(true);
-
-                if(atom_gettype(av+i+6) == A_FLOAT
-                   && atom_gettype(av+i+7) == A_FLOAT
-                   && atom_gettype(av+i+8) == A_FLOAT
-                   && atom_gettype(av+i+9) == A_FLOAT)
-                    tmp->setColor(atom_getfloat(av+i+6), atom_getfloat(av+i+7), atom_getfloat(av+i+8), atom_getfloat(av+i+9));
-
-                if(atom_gettype(av+i+10) == A_SYM && atom_getsym(av+i+10) != hoa_sym_null)
-                    tmp->setDescription(hoa_map_stringFormat(atom_getsym(av+i+10)->s_name)->s_name);
-                else
-                    tmp->setDescription("");
-                i += 11;
             }
-            else if(atom_gettype(av+i) == A_SYM && atom_getsym(av+i) == hoa_sym_group
-               && atom_gettype(av+i+1) == A_FLOAT
-               && atom_gettype(av+i+2) == A_FLOAT)
+        }
+        else
+        {
+            hoa_map_scene_apply(x, &it->f_from);
+            it->f_sources.resize(nsources);
+            for(size_t i = 0; i < nsources; i++)
             {
-                index = ulong(atom_getlong(av+i+1));
-                nsources = ulong(atom_getlong(av+i+2));
+                it->f_sources[i] = x->f_manager->getSource(it->f_from.f_sindices[i]);
+                if(it->f_sources[i])
+                    it->f_sources[i]->setCoordinatesCartesian(ix[i], iy[i], iz[i]);
+            }
+            it->f_lx = it->f_x; it->f_ly = it->f_y; it->f_lz = it->f_z;
+            hoa_map_touch(x);
+        }
+    }
+    else
+    {
+        hoa_map_touch(x);
+    }
 
-                bool newGroupCreated = false;
-                Source::Group* tmp = x->f_manager->getGroup(index);
-                if (!tmp)
-                {
-                    tmp = x->f_manager->createGroup(index);
-                    newGroupCreated = true;
-                }
+    ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
+    ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
+    ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
+    hoa_frame_redraw((t_ebox *)x);
+    hoa_map_output(x);
+    hoa_map_sendBindedMapUpdate(x, BMAP_REDRAW | BMAP_OUTPUT | BMAP_NOTIFY);
+    it->f_version = x->f_store->f_version;
+}
 
-                for(ulong j = 0; j < nsources; j++)
-                {
-                    if(ulong(ac) > i+3+j && atom_gettype(av+i+3+j) == A_FLOAT)
-                    {
-                        Source* src = x->f_manager->getSource(ulong(atom_getlong(av+i+3+j)));
-                        if (src)
-                            tmp->addSource(src);
-                    }
-                }
+/**********************************************************/
+/*                      Trajectories                      */
+/**********************************************************/
 
-                if(ulong(ac) > i+6+nsources && atom_gettype(av+i+3+nsources) == A_FLOAT
-                   && atom_gettype(av+i+4+nsources) == A_FLOAT
-                   && atom_gettype(av+i+5+nsources) == A_FLOAT
-                   && atom_gettype(av+i+6+nsources) == A_FLOAT)
-                    tmp->setColor(atom_getfloat(av+i+3+nsources), atom_getfloat(av+i+4+nsources), atom_getfloat(av+i+5+nsources), atom_getfloat(av+i+6+nsources));
+//! Moves the sources to the position of the playback, the cursors are moved forward or from the nearest keyframe.
+static void hoa_map_trajectory_apply(t_hoa_map *x, const bool seek)
+{
+    t_hoa_map_trajectory* tj = x->f_trajectory;
+    const long long time = (long long)(tj->f_position * 1000.);
+    bool created = false;
+    vector<Source*> moved;
 
-                if(ulong(ac) > i+7+nsources && atom_gettype(av+i+7+nsources) == A_SYM && atom_getsym(av+i+7+nsources) != hoa_sym_null)
-                    tmp->setDescription(hoa_map_stringFormat(atom_getsym(av+i+7+nsources)->s_name)->s_name);
-                else
-                    tmp->setDescription("");
+    for(size_t i = 0; i < tj->f_tracks.size(); i++)
+    {
+        t_hoa_map_track* track = &tj->f_tracks[i];
+        if(seek)
+            hoa_map_track_seek(track, time);
+        else
+            hoa_map_track_advance(track, time);
+        if(!track->f_size)
+            continue;
+
+        t_hoa_map_point const& a = track->f_a;
+        t_hoa_map_point const& b = track->f_b;
+        double abscissa = double(a.f_x), ordinate = double(a.f_y), height = double(a.f_z);
+        if(track->f_has_b && b.f_time > a.f_time && time > a.f_time)
+        {
+            const double ratio = double(time - a.f_time) / double(b.f_time - a.f_time);
+            abscissa += (double(b.f_x) - abscissa) * ratio;
+            ordinate += (double(b.f_y) - ordinate) * ratio;
+            height   += (double(b.f_z) - height) * ratio;
+        }
+        abscissa *= HOA_MAP_TRAJECTORY_QUANTUM;
+        ordinate *= HOA_MAP_TRAJECTORY_QUANTUM;
+        height   *= HOA_MAP_TRAJECTORY_QUANTUM;
 
-                if (newGroupCreated)
-                {
-                    if (!x->f_manager->addGroup(tmp))
-                    {
-                        delete tmp;
-                    }
-                }
-                i += (7+nsources);
-            }
-            else
-                i ++;
+        Source* src = x->f_manager->getSource(track->f_index);
+        if(!src)
+        {
+            src = x->f_manager->newSource(track->f_index);
+            created = true;
+        }
+        if(src->getAbscissa() != abscissa || src->getOrdinate() != ordinate || src->getHeight() != height || src->getMute() != bool(a.f_mute))
+        {
+            src->setCoordinatesCartesian(abscissa, ordinate, height);
+            src->setMute(a.f_mute);
+            moved.push_back(src);
         }
     }
 
+    if(created)
+    {
+        hoa_map_touch(x);
+    }
+    else if(!moved.empty())
+    {
+        for(size_t i = 0; i < moved.size(); i++)
+            hoa_map_refresh(x, moved[i]);
+    }
+    else
+    {
+        return;
+    }
     ebox_notify((t_ebox *)x, NULL, hoa_sym_modified, NULL, NULL);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_sources_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_groups_layer);
-    ebox_redraw((t_ebox *)x);
+    hoa_frame_redraw((t_ebox *)x);
     hoa_map_output(x);
     hoa_map_sendBindedMapUpdate(x, BMAP_REDRAW | BMAP_OUTPUT | BMAP_NOTIFY);
 }
 
+static void hoa_map_trajectory_stop(t_hoa_map *x)
+{
+    x->f_trajectory->f_playing = false;
+    clock_unset(x->f_trajectory->f_clock);
+}
+
+//! Sets the duration to the time of the last point of the trajectories.
+static void hoa_map_trajectory_duration(t_hoa_map_trajectory* tj)
+{
+    tj->f_duration = 0.;
+    for(size_t i = 0; i < tj->f_tracks.size(); i++)
+    {
+        if(tj->f_tracks[i].f_size)
+            tj->f_duration = max(tj->f_duration, double(tj->f_tracks[i].f_last.f_time) / 1000.);
+    }
+}
+
+void hoa_map_trajectory_tick(t_hoa_map *x)
+{
+    t_hoa_map_trajectory* tj = x->f_trajectory;
+    const double elapsed = clock_gettimesince(tj->f_last) * tj->f_speed;
+    bool seek = elapsed < 0.;
+    bool ended = false;
+    tj->f_last = clock_getlogicaltime();
+    tj->f_position += elapsed;
+    if(tj->f_position > tj->f_duration || tj->f_position < 0.)
+    {
+        if(tj->f_loop && tj->f_duration > 0.)
+        {
+            tj->f_position = fmod(tj->f_position, tj->f_duration);
+            if(tj->f_position < 0.)
+                tj->f_position += tj->f_duration;
+            seek = true;
+        }
+        else
+        {
+            tj->f_position = pd_clip_minmax(tj->f_position, 0., tj->f_duration);
+            ended = true;
+        }
+    }
+
+    hoa_map_trajectory_apply(x, seek);
+    if(ended)
+    {
+        t_atom av[2];
+        hoa_map_trajectory_stop(x);
+        atom_setsym(av, hoa_sym_trajectory);
+        atom_setsym(av+1, hoa_sym_end);
+        outlet_list(x->f_out_infos, 0L, 2, av);
+    }
+    else
+    {
+        clock_delay(tj->f_clock, HOA_MAP_TRAJECTORY_TICK);
+    }
+}
+
+//! Rebuilds the keyframes and the last point of a track read from a file, returns false if the stream is invalid.
+static bool hoa_map_track_index(t_hoa_map_track* track)
+{
+    track->f_keys.clear();
+    track->f_size   = 0;
+    track->f_number = 0;
+    track->f_offset = 0;
+    track->f_b.f_time = 0; track->f_b.f_x = track->f_b.f_y = track->f_b.f_z = 0; track->f_b.f_mute = 0;
+    while(track->f_offset < track->f_data.size())
+    {
+        t_hoa_map_point base = track->f_b;
+        if(track->f_size % HOA_MAP_TRAJECTORY_KEYS == 0)
+        {
+            base.f_time = 0; base.f_x = base.f_y = base.f_z = 0;
+        }
+        if(!hoa_map_track_decode(track, base))
+            return false;
+        if(track->f_size % HOA_MAP_TRAJECTORY_KEYS == 0)
+        {
+            t_hoa_map_keyframe key = {track->f_b, track->f_offset};
+            track->f_keys.push_back(key);
+        }
+        track->f_size++;
+    }
+    track->f_last  = track->f_b;
+    track->f_has_b = false;
+    return true;
+}
+
+//! Writes the trajectories in a file: a header "HOAT", the version and the number of tracks, then the index, the number of points, the size and the stream of each track.
+static void hoa_map_trajectory_write(t_hoa_map *x, t_symbol *s)
+{
+    char path[MAXPDSTRING];
+    t_hoa_map_trajectory* tj = x->f_trajectory;
+    vector<unsigned char> bytes;
+    bytes.push_back('H'); bytes.push_back('O'); bytes.push_back('A'); bytes.push_back('T');
+    hoa_map_bytes_put(bytes, HOA_MAP_TRAJECTORY_VERSION, 4);
+    hoa_map_bytes_put(bytes, tj->f_tracks.size(), 4);
+    for(size_t i = 0; i < tj->f_tracks.size(); i++)
+    {
+        t_hoa_map_track const* track = &tj->f_tracks[i];
+        hoa_map_bytes_put(bytes, track->f_index, 4);
+        hoa_map_bytes_put(bytes, track->f_size, 4);
+        hoa_map_bytes_put(bytes, track->f_data.size(), 4);
+        bytes.insert(bytes.end(), track->f_data.begin(), track->f_data.end());
+    }
+
+    canvas_makefilename(eobj_getcanvas(x), s->s_name, path, MAXPDSTRING);
+    FILE* file = sys_fopen(path, "wb");
+    if(!file)
+    {
+        pd_error(x, "hoa.map: can't create %s.", path);
+        return;
+    }
+    if(fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+    {
+        pd_error(x, "hoa.map: error while writing %s.", path);
+    }
+    sys_fclose(file);
+}
+
+static void hoa_map_trajectory_read(t_hoa_map *x, t_symbol *s)
+{
+    char path[MAXPDSTRING];
+    canvas_makefilename(eobj_getcanvas(x), s->s_name, path, MAXPDSTRING);
+    FILE* file = sys_fopen(path, "rb");
+    if(!file)
+    {
+        pd_error(x, "hoa.map: can't open %s.", path);
+        return;
+    }
+    vector<unsigned char> bytes;
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if(size > 0)
+    {
+        bytes.resize(size_t(size));
+        bytes.resize(fread(bytes.data(), 1, bytes.size(), file));
+    }
+    sys_fclose(file);
+
+    unsigned char const* p = bytes.data();
+    unsigned char const* end = p + bytes.size();
+    unsigned long version, ntracks, index, npoints, length;
+    bool valid = bytes.size() >= 12 && p[0] == 'H' && p[1] == 'O' && p[2] == 'A' && p[3] == 'T';
+    if(valid)
+    {
+        p += 4;
+        valid = hoa_map_bytes_get(p, end, version, 4) && version == HOA_MAP_TRAJECTORY_VERSION && hoa_map_bytes_get(p, end, ntracks, 4);
+    }
+
+    t_hoa_map_trajectory loaded;
+    for(unsigned long i = 0; valid && i < ntracks; i++)
+    {
+        valid = hoa_map_bytes_get(p, end, index, 4) && hoa_map_bytes_get(p, end, npoints, 4)
+             && hoa_map_bytes_get(p, end, length, 4) && (unsigned long)(end - p) >= length
+             && index >= 1 && index <= HOA_MAP_MAXINDEX && hoa_map_store_slot(loaded.f_slots, index) < 0;
+        if(valid)
+        {
+            t_hoa_map_track* track = hoa_map_trajectory_track(&loaded, index);
+            track->f_data.assign(p, p + length);
+            valid = hoa_map_track_index(track) && track->f_size == npoints;
+            p += length;
+        }
+    }
+    if(!valid)
+    {
+        pd_error(x, "hoa.map: %s is not a valid trajectory.", path);
+        return;
+    }
+
+    t_hoa_map_trajectory* tj = x->f_trajectory;
+    hoa_map_trajectory_stop(x);
+    tj->f_recording = false;
+    tj->f_tracks.swap(loaded.f_tracks);
+    tj->f_slots.swap(loaded.f_slots);
+    tj->f_position = 0.;
+    hoa_map_trajectory_duration(tj);
+    hoa_map_trajectory_apply(x, true);
+}
+
+//! Controls the trajectories: "record", "play", "seek", "loop", "speed", "clear", "read" and "write".
+void hoa_map_trajectory(t_hoa_map *x, t_symbol *s, int ac, t_atom *av)
+{
+    t_hoa_map_trajectory* tj = x->f_trajectory;
+    if(!ac || !av || atom_gettype(av) != A_SYM)
+        return;
+
+    t_symbol* param = atom_getsym(av);
+    const bool number = ac > 1 && atom_isNumber(av+1);
+    if(param == hoa_sym_record)
+    {
+        if(!number || atom_getfloat(av+1) != 0)
+        {
+            hoa_map_trajectory_stop(x);
+            tj->f_tracks.clear();
+            tj->f_slots.clear();
+            tj->f_position  = 0.;
+            tj->f_start     = clock_getlogicaltime();
+            tj->f_recording = true;
+            hoa_map_record_map(x, NULL);
+        }
+        else if(tj->f_recording)
+        {
+            tj->f_recording = false;
+            hoa_map_trajectory_duration(tj);
+        }
+    }
+    else if(param == hoa_sym_play)
+    {
+        if((!number || atom_getfloat(av+1) != 0) && !tj->f_tracks.empty())
+        {
+            if(tj->f_recording)
+            {
+                tj->f_recording = false;
+                hoa_map_trajectory_duration(tj);
+            }
+            if(tj->f_position >= tj->f_duration && tj->f_speed >= 0.)
+                tj->f_position = 0.;
+            tj->f_playing = true;
+            tj->f_last = clock_getlogicaltime();
+            hoa_map_trajectory_apply(x, true);
+            clock_delay(tj->f_clock, HOA_MAP_TRAJECTORY_TICK);
+        }
+        else
+        {
+            hoa_map_trajectory_stop(x);
+        }
+    }
+    else if(param == hoa_sym_stop)
+    {
+        hoa_map_trajectory_stop(x);
+    }
+    else if(param == hoa_sym_seek && number)
+    {
+        tj->f_position = pd_clip_minmax(double(atom_getfloat(av+1)), 0., tj->f_duration);
+        tj->f_last = clock_getlogicaltime();
+        hoa_map_trajectory_apply(x, true);
+    }
+    else if(param == hoa_sym_loop && number)
+    {
+        tj->f_loop = atom_getfloat(av+1) != 0;
+    }
+    else if(param == hoa_sym_speed && number)
+    {
+        tj->f_speed = atom_getfloat(av+1);
+    }
+    else if(param == hoa_sym_clear)
+    {
+        hoa_map_trajectory_stop(x);
+        tj->f_recording = false;
+        tj->f_tracks.clear();
+        tj->f_slots.clear();
+        tj->f_position = tj->f_duration = 0.;
+    }
+    else if(param == hoa_sym_write && ac > 1 && atom_gettype(av+1) == A_SYM)
+    {
+        hoa_map_trajectory_write(x, atom_getsym(av+1));
+    }
+    else if(param == hoa_sym_read && ac > 1 && atom_gettype(av+1) == A_SYM)
+    {
+        hoa_map_trajectory_read(x, atom_getsym(av+1));
+    }
+}
@@ -18,6 +18,14 @@ typedef struct _hoa_map_tilde
     t_sample*                       f_lines_vector;
     float                           f_ramp;
     int                             f_mode;
+    t_symbol*                       f_mapname;
+    HoaMapSnapshot*                 f_snapshot;
+    unsigned long                   f_version;
+    t_symbol*                       f_radii;
+    t_symbol*                       f_azimuths;
+    t_symbol*                       f_mutes;
+    t_symbol*                       f_arrays[3];
+    float*                          f_arrays_last;
 } t_hoa_map_tilde;
 
 static t_eclass *hoa_map_tilde_class;
@@ -32,8 +40,26 @@ typedef struct _hoa_map_3d_tilde
     t_sample*                       f_lines_vector;
     float                           f_ramp;
     int                             f_mode;
+    t_symbol*                       f_mapname;
+    HoaMapSnapshot*                 f_snapshot;
+    unsigned long                   f_version;
+    t_symbol*                       f_radii;
+    t_symbol*                       f_azimuths;
+    t_symbol*                       f_elevations;
+    t_symbol*                       f_mutes;
+    t_symbol*                       f_arrays[4];
+    float*                          f_arrays_last;
 } t_hoa_map_3d_tilde;
 
+//! Gives the values of an array, returns false if the name is null or if the array doesn't exist.
+static bool hoa_map_tilde_getarray(t_symbol* name, t_word*& values, int& size)
+{
+    if(!name || name == hoa_sym_null || name == hoa_sym_nothing)
+        return false;
+    t_garray* array = (t_garray *)pd_findbyclass(name, garray_class);
+    return array && garray_getfloatwords(array, &size, &values);
+}
+
 static t_eclass *hoa_map_3d_tilde_class;
 
 static void *hoa_map_tilde_new(t_symbol *s, int argc, t_atom *argv)
@@ -83,6 +109,15 @@ static void *hoa_map_tilde_new(t_symbol *s, int argc, t_atom *argv)
 
         x->f_sig_outs       = Signal<t_sample>::alloc(x->f_map->getNumberOfHarmonics() * HOA_MAXBLKSIZE);
         x->f_lines_vector   = Signal<t_sample>::alloc(x->f_map->getNumberOfSources() * 2);
+        x->f_mapname        = hoa_sym_null;
+        x->f_snapshot       = NULL;
+        x->f_version        = 0;
+        x->f_radii          = hoa_sym_null;
+        x->f_azimuths       = hoa_sym_null;
+        x->f_mutes          = hoa_sym_null;
+        x->f_arrays_last    = new float[x->f_map->getNumberOfSources() * 3];
+        for(int i = 0; i < 3; i++)
+            x->f_arrays[i]  = hoa_sym_null;
 
         ebox_attrprocess_viabinbuf(x, d);
 
@@ -150,6 +185,101 @@ static void hoa_map_tilde_list(t_hoa_map_tilde *x, t_symbol* s, int argc, t_atom
     }
 }
 
+//! Receives the packed changes of hoa.map, a tuple of index, mute and coordinates per source.
+static void hoa_map_tilde_packed(t_hoa_map_tilde *x, t_symbol* s, int argc, t_atom* argv)
+{
+    const bool polar = (s == hoa_sym_polar);
+    for(int i = 0; i + 4 < argc; i += 5)
+    {
+        long index = atom_getlong(argv+i);
+        if(index < 1 || (ulong)index > x->f_map->getNumberOfSources())
+            continue;
+
+        x->f_map->setMute(ulong(index-1), atom_getlong(argv+i+1));
+        if(polar)
+        {
+            x->f_lines->setRadius(ulong(index-1), atom_getfloat(argv+i+2));
+            x->f_lines->setAzimuth(ulong(index-1), atom_getfloat(argv+i+3));
+        }
+        else
+        {
+            x->f_lines->setRadius(ulong(index-1), Math<float>::radius(atom_getfloat(argv+i+2), atom_getfloat(argv+i+3)));
+            x->f_lines->setAzimuth(ulong(index-1), Math<float>::azimuth(atom_getfloat(argv+i+2), atom_getfloat(argv+i+3)));
+        }
+    }
+}
+
+//! Reads the radii, the azimuths and the mutes of the sources in the arrays, only the values that differ from the last block are applied.
+static void hoa_map_tilde_read_arrays(t_hoa_map_tilde *x)
+{
+    const ulong nsources = x->f_map->getNumberOfSources();
+    t_symbol* names[3] = {x->f_radii, x->f_azimuths, x->f_mutes};
+    for(int k = 0; k < 3; k++)
+    {
+        float* last = x->f_arrays_last + k * nsources;
+        if(names[k] != x->f_arrays[k])
+        {
+            x->f_arrays[k] = names[k];
+            for(ulong i = 0; i < nsources; i++)
+                last[i] = NAN;
+        }
+
+        t_word* values;
+        int size;
+        if(!hoa_map_tilde_getarray(names[k], values, size))
+            continue;
+
+        const ulong n = min(nsources, ulong(size));
+        for(ulong i = 0; i < n; i++)
+        {
+            const float value = values[i].w_float;
+            if(value != last[i])
+            {
+                last[i] = value;
+                if(k == 0)
+                    x->f_lines->setRadius(i, value);
+                else if(k == 1)
+                    x->f_lines->setAzimuth(i, value);
+                else
+                    x->f_map->setMute(i, value != 0.f);
+            }
+        }
+    }
+}
+
+//! Reads the sources of the bound hoa.map that changed since the last block, then the arrays.
+static void hoa_map_tilde_follow(t_hoa_map_tilde *x)
+{
+    if(x->f_snapshot && x->f_snapshot->getVersion() != x->f_version)
+    {
+        const size_t size = min(size_t(x->f_map->getNumberOfSources()), x->f_snapshot->getSize());
+        for(size_t i = 0; i < size; i++)
+        {
+            HoaMapSnapshot::Source const& src = x->f_snapshot->getSource(i);
+            if(src.version > x->f_version)
+            {
+                x->f_map->setMute(ulong(i), src.mute);
+                x->f_lines->setRadius(ulong(i), src.radius);
+                x->f_lines->setAzimuth(ulong(i), src.azimuth);
+            }
+        }
+        x->f_version = x->f_snapshot->getVersion();
+    }
+    hoa_map_tilde_read_arrays(x);
+}
+
+static t_pd_err hoa_map_tilde_mapname_set(t_hoa_map_tilde *x, t_object *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_SYM && atom_getsym(argv) != x->f_mapname)
+    {
+        hoa_map_snapshot_release((t_object *)x, x->f_mapname);
+        x->f_mapname    = atom_getsym(argv);
+        x->f_snapshot   = hoa_map_snapshot_acquire((t_object *)x, x->f_mapname);
+        x->f_version    = 0;
+    }
+    return 0;
+}
+
 static t_pd_err hoa_map_tilde_ramp_set(t_hoa_map_tilde *x, t_object *attr, int argc, t_atom *argv)
 {
     if(argc && argv)
@@ -165,6 +295,7 @@ static t_pd_err hoa_map_tilde_ramp_set(t_hoa_map_tilde *x, t_object *attr, int a
 
 static void hoa_map_tilde_perform_multisources(t_hoa_map_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_tilde_follow(x);
 	ulong nsources = x->f_map->getNumberOfSources();
     for(long i = 0; i < numins; i++)
     {
@@ -188,6 +319,7 @@ static void hoa_map_tilde_perform_multisources(t_hoa_map_tilde *x, t_object *dsp
 
 static void hoa_map_tilde_perform(t_hoa_map_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_tilde_follow(x);
     for(long i = 0; i < sampleframes; i++)
     {
 		x->f_lines->process(x->f_lines_vector);
@@ -203,6 +335,7 @@ static void hoa_map_tilde_perform(t_hoa_map_tilde *x, t_object *dsp64, t_sample
 
 static void hoa_map_tilde_perform_in1(t_hoa_map_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -231,6 +364,7 @@ static void hoa_map_tilde_perform_in1(t_hoa_map_tilde *x, t_object *dsp64, t_sam
 
 static void hoa_map_tilde_perform_in2(t_hoa_map_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -259,6 +393,7 @@ static void hoa_map_tilde_perform_in2(t_hoa_map_tilde *x, t_object *dsp64, t_sam
 
 static void hoa_map_tilde_perform_in1_in2(t_hoa_map_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -307,11 +442,13 @@ static void hoa_map_tilde_dsp(t_hoa_map_tilde *x, t_object *dsp, short *count, d
 static void hoa_map_tilde_free(t_hoa_map_tilde *x)
 {
 	eobj_dspfree(x);
+    hoa_map_snapshot_release((t_object *)x, x->f_mapname);
 	delete x->f_lines;
 	delete x->f_map;
     Signal<t_sample>::free(x->f_sig_ins);
     Signal<t_sample>::free(x->f_sig_outs);
 	Signal<t_sample>::free(x->f_lines_vector);
+    delete [] x->f_arrays_last;
 }
 
 extern "C" void setup_hoa0x2e2d0x2emap_tilde(void)
@@ -325,6 +462,8 @@ extern "C" void setup_hoa0x2e2d0x2emap_tilde(void)
     
     eclass_addmethod(c, (method)hoa_map_tilde_dsp,          "dsp",      A_CANT, 0);
     eclass_addmethod(c, (method)hoa_map_tilde_list,         "list",     A_GIMME, 0);
+    eclass_addmethod(c, (method)hoa_map_tilde_packed,       "polar",    A_GIMME, 0);
+    eclass_addmethod(c, (method)hoa_map_tilde_packed,       "cartesian",A_GIMME, 0);
     eclass_addmethod(c, (method)hoa_map_tilde_float,        "float",    A_FLOAT, 0);
 
     CLASS_ATTR_FLOAT            (c, "ramp", 0, t_hoa_map_tilde, f_ramp);
@@ -334,6 +473,35 @@ extern "C" void setup_hoa0x2e2d0x2emap_tilde(void)
     CLASS_ATTR_ACCESSORS		(c, "ramp", NULL, hoa_map_tilde_ramp_set);
     CLASS_ATTR_SAVE				(c, "ramp", 1);
 
+    CLASS_ATTR_SYMBOL           (c, "mapname", 0, t_hoa_map_tilde, f_mapname);
+    CLASS_ATTR_CATEGORY			(c, "mapname", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "mapname", 0, "Map Name");
+    CLASS_ATTR_ORDER			(c, "mapname", 0, "1");
+    CLASS_ATTR_ACCESSORS		(c, "mapname", NULL, hoa_map_tilde_mapname_set);
+    CLASS_ATTR_DEFAULT			(c, "mapname", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "mapname", 1);
+
+    CLASS_ATTR_SYMBOL           (c, "radii", 0, t_hoa_map_tilde, f_radii);
+    CLASS_ATTR_CATEGORY			(c, "radii", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "radii", 0, "Radii Array");
+    CLASS_ATTR_ORDER			(c, "radii", 0, "2");
+    CLASS_ATTR_DEFAULT			(c, "radii", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "radii", 1);
+
+    CLASS_ATTR_SYMBOL           (c, "azimuths", 0, t_hoa_map_tilde, f_azimuths);
+    CLASS_ATTR_CATEGORY			(c, "azimuths", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "azimuths", 0, "Azimuths Array");
+    CLASS_ATTR_ORDER			(c, "azimuths", 0, "3");
+    CLASS_ATTR_DEFAULT			(c, "azimuths", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "azimuths", 1);
+
+    CLASS_ATTR_SYMBOL           (c, "mutes", 0, t_hoa_map_tilde, f_mutes);
+    CLASS_ATTR_CATEGORY			(c, "mutes", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "mutes", 0, "Mutes Array");
+    CLASS_ATTR_ORDER			(c, "mutes", 0, "4");
+    CLASS_ATTR_DEFAULT			(c, "mutes", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "mutes", 1);
+
     eclass_register(CLASS_OBJ, c);
     hoa_map_tilde_class = c;
 }
@@ -385,6 +553,16 @@ static void *hoa_map_3d_tilde_new(t_symbol *s, int argc, t_atom *argv)
 
         x->f_sig_outs       = Signal<t_sample>::alloc(x->f_map->getNumberOfHarmonics() * HOA_MAXBLKSIZE);
         x->f_lines_vector   = Signal<t_sample>::alloc(x->f_map->getNumberOfSources() * 3);
+        x->f_mapname        = hoa_sym_null;
+        x->f_snapshot       = NULL;
+        x->f_version        = 0;
+        x->f_radii          = hoa_sym_null;
+        x->f_azimuths       = hoa_sym_null;
+        x->f_elevations     = hoa_sym_null;
+        x->f_mutes          = hoa_sym_null;
+        x->f_arrays_last    = new float[x->f_map->getNumberOfSources() * 4];
+        for(int i = 0; i < 4; i++)
+            x->f_arrays[i]  = hoa_sym_null;
 
         ebox_attrprocess_viabinbuf(x, d);
 
@@ -473,6 +651,107 @@ static void hoa_map_3d_tilde_list(t_hoa_map_3d_tilde *x, t_symbol* s, int argc,
     }
 }
 
+//! Receives the packed changes of hoa.map, a tuple of index, mute and coordinates per source.
+static void hoa_map_3d_tilde_packed(t_hoa_map_3d_tilde *x, t_symbol* s, int argc, t_atom* argv)
+{
+    const bool polar = (s == hoa_sym_polar);
+    for(int i = 0; i + 4 < argc; i += 5)
+    {
+        long index = atom_getlong(argv+i);
+        if(index < 1 || (ulong)index > x->f_map->getNumberOfSources())
+            continue;
+
+        x->f_map->setMute(ulong(index-1), atom_getlong(argv+i+1));
+        if(polar)
+        {
+            x->f_lines->setRadius(ulong(index-1), atom_getfloat(argv+i+2));
+            x->f_lines->setAzimuth(ulong(index-1), atom_getfloat(argv+i+3));
+            x->f_lines->setElevation(ulong(index-1), atom_getfloat(argv+i+4));
+        }
+        else
+        {
+            const float abscissa = atom_getfloat(argv+i+2), ordinate = atom_getfloat(argv+i+3), height = atom_getfloat(argv+i+4);
+            x->f_lines->setRadius(ulong(index-1), Math<float>::radius(abscissa, ordinate, height));
+            x->f_lines->setAzimuth(ulong(index-1), Math<float>::azimuth(abscissa, ordinate, height));
+            x->f_lines->setElevation(ulong(index-1), Math<float>::elevation(abscissa, ordinate, height));
+        }
+    }
+}
+
+//! Reads the radii, the azimuths, the elevations and the mutes of the sources in the arrays, only the values that differ from the last block are applied.
+static void hoa_map_3d_tilde_read_arrays(t_hoa_map_3d_tilde *x)
+{
+    const ulong nsources = x->f_map->getNumberOfSources();
+    t_symbol* names[4] = {x->f_radii, x->f_azimuths, x->f_elevations, x->f_mutes};
+    for(int k = 0; k < 4; k++)
+    {
+        float* last = x->f_arrays_last + k * nsources;
+        if(names[k] != x->f_arrays[k])
+        {
+            x->f_arrays[k] = names[k];
+            for(ulong i = 0; i < nsources; i++)
+                last[i] = NAN;
+        }
+
+        t_word* values;
+        int size;
+        if(!hoa_map_tilde_getarray(names[k], values, size))
+            continue;
+
+        const ulong n = min(nsources, ulong(size));
+        for(ulong i = 0; i < n; i++)
+        {
+            const float value = values[i].w_float;
+            if(value != last[i])
+            {
+                last[i] = value;
+                if(k == 0)
+                    x->f_lines->setRadius(i, value);
+                else if(k == 1)
+                    x->f_lines->setAzimuth(i, value);
+                else if(k == 2)
+                    x->f_lines->setElevation(i, value);
+                else
+                    x->f_map->setMute(i, value != 0.f);
+            }
+        }
+    }
+}
+
+//! Reads the sources of the bound hoa.map that changed since the last block, then the arrays.
+static void hoa_map_3d_tilde_follow(t_hoa_map_3d_tilde *x)
+{
+    if(x->f_snapshot && x->f_snapshot->getVersion() != x->f_version)
+    {
+        const size_t size = min(size_t(x->f_map->getNumberOfSources()), x->f_snapshot->getSize());
+        for(size_t i = 0; i < size; i++)
+        {
+            HoaMapSnapshot::Source const& src = x->f_snapshot->getSource(i);
+            if(src.version > x->f_version)
+            {
+                x->f_map->setMute(ulong(i), src.mute);
+                x->f_lines->setRadius(ulong(i), src.radius);
+                x->f_lines->setAzimuth(ulong(i), src.azimuth);
+                x->f_lines->setElevation(ulong(i), src.elevation);
+            }
+        }
+        x->f_version = x->f_snapshot->getVersion();
+    }
+    hoa_map_3d_tilde_read_arrays(x);
+}
+
+static t_pd_err hoa_map_3d_tilde_mapname_set(t_hoa_map_3d_tilde *x, t_object *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_SYM && atom_getsym(argv) != x->f_mapname)
+    {
+        hoa_map_snapshot_release((t_object *)x, x->f_mapname);
+        x->f_mapname    = atom_getsym(argv);
+        x->f_snapshot   = hoa_map_snapshot_acquire((t_object *)x, x->f_mapname);
+        x->f_version    = 0;
+    }
+    return 0;
+}
+
 static t_pd_err hoa_map_3d_tilde_ramp_set(t_hoa_map_3d_tilde *x, t_object *attr, int argc, t_atom *argv)
 {
     if(argc && argv)
@@ -489,6 +768,7 @@ static t_pd_err hoa_map_3d_tilde_ramp_set(t_hoa_map_3d_tilde *x, t_object *attr,
 
 static void hoa_map_3d_tilde_perform_in1_in2_in3(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -517,6 +797,7 @@ static void hoa_map_3d_tilde_perform_in1_in2_in3(t_hoa_map_3d_tilde *x, t_object
 
 static void hoa_map_3d_tilde_perform_in1_in2(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -547,6 +828,7 @@ static void hoa_map_3d_tilde_perform_in1_in2(t_hoa_map_3d_tilde *x, t_object *ds
 
 static void hoa_map_3d_tilde_perform_in1_in3(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -578,6 +860,7 @@ static void hoa_map_3d_tilde_perform_in1_in3(t_hoa_map_3d_tilde *x, t_object *ds
 /*
 static void hoa_map_3d_tilde_perform_in2_in3(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -609,6 +892,7 @@ static void hoa_map_3d_tilde_perform_in2_in3(t_hoa_map_3d_tilde *x, t_object *ds
 
 static void hoa_map_3d_tilde_perform_in1(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -639,6 +923,7 @@ static void hoa_map_3d_tilde_perform_in1(t_hoa_map_3d_tilde *x, t_object *dsp64,
 
 static void hoa_map_3d_tilde_perform_in2(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -669,6 +954,7 @@ static void hoa_map_3d_tilde_perform_in2(t_hoa_map_3d_tilde *x, t_object *dsp64,
 
 static void hoa_map_3d_tilde_perform_in3(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     if(!x->f_mode)
     {
         for(long i = 0; i < sampleframes; i++)
@@ -699,6 +985,7 @@ static void hoa_map_3d_tilde_perform_in3(t_hoa_map_3d_tilde *x, t_object *dsp64,
 
 static void hoa_map_3d_tilde_perform(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     for(long i = 0; i < sampleframes; i++)
     {
         x->f_lines->process(x->f_lines_vector);
@@ -715,6 +1002,7 @@ static void hoa_map_3d_tilde_perform(t_hoa_map_3d_tilde *x, t_object *dsp64, t_s
 
 static void hoa_map_3d_tilde_perform_multisources(t_hoa_map_3d_tilde *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    hoa_map_3d_tilde_follow(x);
     ulong nsources = x->f_map->getNumberOfSources();
     for(long i = 0; i < numins; i++)
     {
@@ -770,11 +1058,13 @@ static void hoa_map_3d_tilde_dsp(t_hoa_map_3d_tilde *x, t_object *dsp, short *co
 static void hoa_map_3d_tilde_free(t_hoa_map_3d_tilde *x)
 {
     eobj_dspfree(x);
+    hoa_map_snapshot_release((t_object *)x, x->f_mapname);
     delete x->f_lines;
     delete x->f_map;
     Signal<t_sample>::free(x->f_sig_ins);
     Signal<t_sample>::free(x->f_sig_outs);
     Signal<t_sample>::free(x->f_lines_vector);
+    delete [] x->f_arrays_last;
 }
 
 extern "C" void setup_hoa0x2e3d0x2emap_tilde(void)
@@ -787,6 +1077,8 @@ extern "C" void setup_hoa0x2e3d0x2emap_tilde(void)
     
     eclass_addmethod(c, (method)hoa_map_3d_tilde_dsp,          "dsp",      A_CANT, 0);
     eclass_addmethod(c, (method)hoa_map_3d_tilde_list,         "list",     A_GIMME, 0);
+    eclass_addmethod(c, (method)hoa_map_3d_tilde_packed,       "polar",    A_GIMME, 0);
+    eclass_addmethod(c, (method)hoa_map_3d_tilde_packed,       "cartesian",A_GIMME, 0);
     eclass_addmethod(c, (method)hoa_map_3d_tilde_float,        "float",    A_FLOAT, 0);
 
     CLASS_ATTR_DOUBLE           (c, "ramp", 0, t_hoa_map_3d_tilde, f_ramp);
@@ -796,6 +1088,42 @@ extern "C" void setup_hoa0x2e3d0x2emap_tilde(void)
     CLASS_ATTR_ACCESSORS		(c, "ramp", NULL, hoa_map_3d_tilde_ramp_set);
     CLASS_ATTR_SAVE				(c, "ramp", 1);
 
+    CLASS_ATTR_SYMBOL           (c, "mapname", 0, t_hoa_map_3d_tilde, f_mapname);
+    CLASS_ATTR_CATEGORY			(c, "mapname", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "mapname", 0, "Map Name");
+    CLASS_ATTR_ORDER			(c, "mapname", 0, "1");
+    CLASS_ATTR_ACCESSORS		(c, "mapname", NULL, hoa_map_3d_tilde_mapname_set);
+    CLASS_ATTR_DEFAULT			(c, "mapname", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "mapname", 1);
+
+    CLASS_ATTR_SYMBOL           (c, "radii", 0, t_hoa_map_3d_tilde, f_radii);
+    CLASS_ATTR_CATEGORY			(c, "radii", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "radii", 0, "Radii Array");
+    CLASS_ATTR_ORDER			(c, "radii", 0, "2");
+    CLASS_ATTR_DEFAULT			(c, "radii", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "radii", 1);
+
+    CLASS_ATTR_SYMBOL           (c, "azimuths", 0, t_hoa_map_3d_tilde, f_azimuths);
+    CLASS_ATTR_CATEGORY			(c, "azimuths", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "azimuths", 0, "Azimuths Array");
+    CLASS_ATTR_ORDER			(c, "azimuths", 0, "3");
+    CLASS_ATTR_DEFAULT			(c, "azimuths", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "azimuths", 1);
+
+    CLASS_ATTR_SYMBOL           (c, "elevations", 0, t_hoa_map_3d_tilde, f_elevations);
+    CLASS_ATTR_CATEGORY			(c, "elevations", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "elevations", 0, "Elevations Array");
+    CLASS_ATTR_ORDER			(c, "elevations", 0, "4");
+    CLASS_ATTR_DEFAULT			(c, "elevations", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "elevations", 1);
+
+    CLASS_ATTR_SYMBOL           (c, "mutes", 0, t_hoa_map_3d_tilde, f_mutes);
+    CLASS_ATTR_CATEGORY			(c, "mutes", 0, "Name");
+    CLASS_ATTR_LABEL			(c, "mutes", 0, "Mutes Array");
+    CLASS_ATTR_ORDER			(c, "mutes", 0, "5");
+    CLASS_ATTR_DEFAULT			(c, "mutes", 0, "(null)");
+    CLASS_ATTR_SAVE				(c, "mutes", 1);
+
     eclass_register(CLASS_OBJ, c);
     hoa_map_3d_tilde_class = c;
 }
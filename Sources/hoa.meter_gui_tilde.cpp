@@ -15,16 +15,158 @@ static double round(double val)
 }
 #endif
 
+//! The layout of the snapshots published by the perform methods of the meters.
+/** The cross accumulators hold the sums over the interval of the squared pressure and of the pressure multiplied by each coordinate of the velocity, the pressure being the sum of the channels and the velocity the sum of the channels weighted by their axes.
+ */
+#define HOA_METER_PEAKS     0
+#define HOA_METER_SQUARES   HOA_MAX_PLANEWAVES
+#define HOA_METER_CROSS     (HOA_MAX_PLANEWAVES * 2)
+#define HOA_METER_COUNT     (HOA_MAX_PLANEWAVES * 2 + 4)
+#define HOA_METER_SIZE      (HOA_MAX_PLANEWAVES * 2 + 5)
+
+//! Accumulates a block in the snapshot of the writer and publishes it once the interval is reached and the previous snapshot was read.
+/** The axes are the abscissas, the ordinates and the heights of the channels, the scratch holds four vectors of sampleframes samples. The channels are summed sample by sample so the loops vectorize. While the reader hasn't taken the previous snapshot, the peaks and the sums keep growing in the same one, so a slow reader gets every interval. If the reader stops, the accumulation restarts after HOA_SNAPSHOT_MAXPERIODS intervals. The cross accumulators only feed the velocity vector, they are skipped when it isn't displayed nor output.
+ */
+static void hoa_meter_accumulate(HoaTripleBuffer* snapshot, t_sample const* axes, t_sample* scratch, t_sample **ins, long numins, long sampleframes, long& ramp, long period, const bool cross)
+{
+    t_sample* snap = snapshot->write();
+    for(long i = 0; i < numins; i++)
+    {
+        snap[HOA_METER_PEAKS + i]   = hoa_signal_peak(sampleframes, ins[i], snap[HOA_METER_PEAKS + i]);
+        snap[HOA_METER_SQUARES + i] = hoa_signal_sumsquares(sampleframes, ins[i], snap[HOA_METER_SQUARES + i]);
+    }
+    if(cross)
+    {
+        t_sample* p  = scratch;
+        t_sample* vx = scratch + sampleframes;
+        t_sample* vy = scratch + sampleframes * 2;
+        t_sample* vz = scratch + sampleframes * 3;
+        memset(scratch, 0, size_t(sampleframes * 4) * sizeof(t_sample));
+        for(long i = 0; i < numins; i++)
+        {
+            const t_sample* in = ins[i];
+            const t_sample ax = axes[i];
+            const t_sample ay = axes[HOA_MAX_PLANEWAVES + i];
+            const t_sample az = axes[HOA_MAX_PLANEWAVES * 2 + i];
+            for(long j = 0; j < sampleframes; j++)
+            {
+                p[j]  += in[j];
+                vx[j] += in[j] * ax;
+                vy[j] += in[j] * ay;
+                vz[j] += in[j] * az;
+            }
+        }
+        t_sample pp = 0, px = 0, py = 0, pz = 0;
+        for(long j = 0; j < sampleframes; j++)
+        {
+            pp += p[j] * p[j];
+            px += p[j] * vx[j];
+            py += p[j] * vy[j];
+            pz += p[j] * vz[j];
+        }
+        snap[HOA_METER_CROSS]     += pp;
+        snap[HOA_METER_CROSS + 1] += px;
+        snap[HOA_METER_CROSS + 2] += py;
+        snap[HOA_METER_CROSS + 3] += pz;
+    }
+
+    ramp += sampleframes;
+    if(ramp >= period && !snapshot->pending())
+    {
+        snap[HOA_METER_COUNT] = t_sample(ramp);
+        snapshot->publish();
+        memset(snapshot->write(), 0, HOA_METER_SIZE * sizeof(t_sample));
+        ramp = 0;
+    }
+    else if(ramp >= period * HOA_SNAPSHOT_MAXPERIODS)
+    {
+        memset(snap, 0, HOA_METER_SIZE * sizeof(t_sample));
+        ramp = 0;
+    }
+}
+
+//! Reads the latest snapshot and returns NULL if nothing new was published.
+static t_sample const* hoa_meter_read(HoaTripleBuffer* snapshot)
+{
+    bool fresh;
+    t_sample const* snap = snapshot->read(fresh);
+    if(fresh && snap[HOA_METER_COUNT] > 0)
+    {
+        return snap;
+    }
+    return NULL;
+}
+
+//! Derives the vectors averaged over the interval of a snapshot.
+/** The velocity vector is the ratio of the cross accumulators and the energy vector is the barycenter of the axes weighted by the sums of squares. The number of coordinates is 2 or 3, a NULL vector is not computed.
+ */
+static void hoa_meter_vectors(t_sample const* snap, t_sample const* axes, const ulong nplws, const ulong ncoords, t_sample* velocity, t_sample* energy)
+{
+    if(velocity)
+    {
+        const t_sample pp = snap[HOA_METER_CROSS];
+        for(ulong j = 0; j < ncoords; j++)
+        {
+            velocity[j] = pp > 0 ? snap[HOA_METER_CROSS + 1 + j] / pp : t_sample(0.);
+        }
+    }
+    if(energy)
+    {
+        t_sample sum = 0, coords[3] = {0, 0, 0};
+        for(ulong i = 0; i < nplws; i++)
+        {
+            const t_sample sq = snap[HOA_METER_SQUARES + i];
+            sum       += sq;
+            coords[0] += sq * axes[i];
+            coords[1] += sq * axes[HOA_MAX_PLANEWAVES + i];
+            coords[2] += sq * axes[HOA_MAX_PLANEWAVES * 2 + i];
+        }
+        for(ulong j = 0; j < ncoords; j++)
+        {
+            energy[j] = sum > 0 ? coords[j] / sum : t_sample(0.);
+        }
+    }
+}
+
+//! Stores the axes of the channels with the rotation, the audio thread weights the velocity with them.
+static void hoa_meter_axes(Vector<Hoa2d, t_sample>* vector, t_sample* axes)
+{
+    for(ulong i = 0; i < vector->getNumberOfPlanewaves(); i++)
+    {
+        axes[i]                             = Math<t_sample>::abscissa(1., vector->getPlanewaveAzimuth(i));
+        axes[HOA_MAX_PLANEWAVES + i]        = Math<t_sample>::ordinate(1., vector->getPlanewaveAzimuth(i));
+        axes[HOA_MAX_PLANEWAVES * 2 + i]    = 0.;
+    }
+}
+
+static void hoa_meter_axes(Vector<Hoa3d, t_sample>* vector, t_sample* axes)
+{
+    for(ulong i = 0; i < vector->getNumberOfPlanewaves(); i++)
+    {
+        axes[i]                             = Math<t_sample>::abscissa(1., vector->getPlanewaveAzimuth(i), vector->getPlanewaveElevation(i));
+        axes[HOA_MAX_PLANEWAVES + i]        = Math<t_sample>::ordinate(1., vector->getPlanewaveAzimuth(i), vector->getPlanewaveElevation(i));
+        axes[HOA_MAX_PLANEWAVES * 2 + i]    = Math<t_sample>::height(1., vector->getPlanewaveAzimuth(i), vector->getPlanewaveElevation(i));
+    }
+}
+
 typedef struct  _hoa_meter
 {
 	t_edspbox               f_box;
     Meter<Hoa2d, t_sample>* f_meter;
     Vector<Hoa2d, t_sample>*f_vector;
-    t_sample*               f_signals;
+    HoaTripleBuffer*        f_snapshot;
+    t_sample*               f_axes;
+    t_sample*               f_scratch;
+    double                  f_samplerate;
     t_sample                f_vector_coords[4];
+    long                    f_vector_pixels[4];
+    long                    f_leds[HOA_MAX_PLANEWAVES];
     long                    f_ramp;
 	int                     f_startclock;
 	long                    f_interval;
+    long                    f_output;
+    t_clock*                f_output_clock;
+    t_outlet*               f_out;
 
     t_symbol*               f_vector_type;
     t_symbol*               f_clockwise;
@@ -43,12 +185,40 @@ typedef struct  _hoa_meter
     double                  f_center;
 	double                  f_radius_center;
 
-	t_clock*                f_clock;
     void*                   f_attrs;
 
 } t_hoa_meter;
 
 static t_eclass *hoa_meter_class;
+static t_symbol *hoa_meter_leds_layers[HOA_MAX_PLANEWAVES];
+
+//! Returns the number of lit LEDs of a channel, plus 16 if the over LED is lit.
+static long hoa_meter_getleds(t_hoa_meter *x, ulong index)
+{
+    long leds = 0;
+    const float energy = x->f_meter->getPlanewaveEnergy(index);
+    for(float dB = -39.f; leds < 12 && energy > dB; dB += 3.f)
+    {
+        leds++;
+    }
+    return x->f_meter->getPlanewaveOverLed(index) ? leds + 16 : leds;
+}
+
+//! Returns the position in pixels of a vector, the vectors are only redrawn when it changes.
+static long hoa_meter_getpixel(t_hoa_meter *x, t_sample coord)
+{
+    return long(coord * x->f_radius_center * 0.85);
+}
+
+//! Invalidates the layers of all the channels, they will be redrawn whatever their states.
+static void hoa_meter_invalidate_leds(t_hoa_meter *x)
+{
+    for(ulong i = 0; i < HOA_MAX_PLANEWAVES; i++)
+    {
+        x->f_leds[i] = -1;
+        ebox_invalidate_layer((t_ebox *)x, hoa_meter_leds_layers[i]);
+    }
+}
 
 static void hoa_meter_getdrawparams(t_hoa_meter *x, t_object *patcherview, t_edrawparams *params)
 {
@@ -98,12 +268,13 @@ static t_pd_err channels_set(t_hoa_meter *x, void *attr, int argc, t_atom *argv)
 
                 x->f_meter->computeRendering();
                 x->f_vector->computeRendering();
+                hoa_meter_axes(x->f_vector, x->f_axes);
                 eobj_resize_inputs((t_ebox *)x, long(x->f_meter->getNumberOfPlanewaves()));
 
                 ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
-                ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
+                hoa_meter_invalidate_leds(x);
                 ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-                ebox_redraw((t_ebox *)x);
+                hoa_frame_redraw((t_ebox *)x);
                 canvas_resume_dsp(dspState);
             }
         }
@@ -145,11 +316,12 @@ static t_pd_err angles_set(t_hoa_meter *x, void *attr, int argc, t_atom *argv)
 
         x->f_meter->computeRendering();
         x->f_vector->computeRendering();
+        hoa_meter_axes(x->f_vector, x->f_axes);
 
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
-        ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
+        hoa_meter_invalidate_leds(x);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
     return 0;
 }
@@ -177,12 +349,13 @@ static t_pd_err offset_set(t_hoa_meter *x, void *attr, int argc, t_atom *argv)
         x->f_vector->setPlanewavesRotation(0., 0., atom_getfloat(argv) / 360 * HOA_2PI);
         x->f_meter->setPlanewavesRotation(0., 0., atom_getfloat(argv) / 360 * HOA_2PI);
         x->f_vector->computeRendering();
+        hoa_meter_axes(x->f_vector, x->f_axes);
         x->f_meter->computeRendering();
 
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
-        ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
+        hoa_meter_invalidate_leds(x);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
     return 0;
 }
@@ -214,12 +387,30 @@ static t_pd_err vectors_set(t_hoa_meter *x, void *attr, int argc, t_atom *argv)
                 x->f_vector_type = hoa_sym_none;
         }
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
     return 0;
 }
 
 
+static t_pd_err output_set(t_hoa_meter *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        const long output = atom_getlong(argv);
+        x->f_output = output > 0 ? max(output, (long)HOA_FRAME_INTERVAL) : 0;
+        if(x->f_output && canvas_dspstate)
+        {
+            clock_delay(x->f_output_clock, x->f_output);
+        }
+        else
+        {
+            clock_unset(x->f_output_clock);
+        }
+    }
+    return 0;
+}
+
 static t_pd_err rotation_set(t_hoa_meter *x, void *attr, int argc, t_atom *argv)
 {
     if(argc && argv)
@@ -240,55 +431,133 @@ static t_pd_err rotation_set(t_hoa_meter *x, void *attr, int argc, t_atom *argv)
         }
 
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
-        ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
+        hoa_meter_invalidate_leds(x);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
     return 0;
 }
 
-static void hoa_meter_perform(t_hoa_meter *x, t_object *dsp, t_sample **ins, long numins, t_sample **outs, long no, long sampleframes, long f,void *up)
+//! Returns the interval of the snapshots, the data output is the only consumer when it's on so it sets the pace and the GUI displays its windows.
+static long hoa_meter_getperiod(t_hoa_meter *x)
 {
-    for(long i = 0; i < numins; i++)
+    if(x->f_output)
     {
-        Signal<t_sample>::copy(ulong(sampleframes), ins[i], 1, x->f_signals+i, ulong(numins));
-    }
-    for(x->f_ramp = 0; x->f_ramp < sampleframes; x->f_ramp++)
-    {
-        x->f_meter->process(x->f_signals + numins * x->f_ramp);
+        return x->f_output;
     }
+    return x->f_interval;
+}
+
+static void hoa_meter_perform(t_hoa_meter *x, t_object *dsp, t_sample **ins, long numins, t_sample **outs, long no, long sampleframes, long f,void *up)
+{
+    hoa_meter_accumulate(x->f_snapshot, x->f_axes, x->f_scratch, ins, numins, sampleframes, x->f_ramp, long(x->f_samplerate * double(hoa_meter_getperiod(x)) * 0.001), x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_velocity);
     if(x->f_startclock)
     {
         x->f_startclock = 0;
-        clock_delay(x->f_clock,0);
+        hoa_frame_start();
     }
 }
 
+//! Consumes the latest snapshot, the data output drives the analysis when it's on, otherwise the GUI does.
+static void hoa_meter_process(t_hoa_meter *x, long interval)
+{
+    const ulong nplws = x->f_meter->getNumberOfPlanewaves();
+    t_sample const* snap = hoa_meter_read(x->f_snapshot);
+    if(snap)
+    {
+        x->f_meter->process(snap + HOA_METER_PEAKS);
+        const bool velocity = x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_velocity;
+        const bool energy   = x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_energy;
+        hoa_meter_vectors(snap, x->f_axes, nplws, 2, velocity ? x->f_vector_coords : NULL, energy ? x->f_vector_coords + 2 : NULL);
+    }
+
+    x->f_meter->tick(ulong(1000 / interval));
+}
+
+static void hoa_meter_output(t_hoa_meter *x)
+{
+    if(!x->f_output)
+    {
+        return;
+    }
+    hoa_meter_process(x, x->f_output);
+
+    t_atom av[HOA_MAX_PLANEWAVES];
+    const ulong nplws = x->f_meter->getNumberOfPlanewaves();
+    for(ulong i = 0; i < nplws; i++)
+    {
+        atom_setfloat(av+i, x->f_meter->getPlanewaveEnergy(i));
+    }
+    outlet_anything(x->f_out, hoa_sym_peaks, int(nplws), av);
+    if(x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_energy)
+    {
+        atom_setfloat(av, x->f_vector_coords[2]);
+        atom_setfloat(av+1, x->f_vector_coords[3]);
+        outlet_anything(x->f_out, hoa_sym_energy, 2, av);
+    }
+    if(x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_velocity)
+    {
+        atom_setfloat(av, x->f_vector_coords[0]);
+        atom_setfloat(av+1, x->f_vector_coords[1]);
+        outlet_anything(x->f_out, hoa_sym_velocity, 2, av);
+    }
+
+    if(canvas_dspstate)
+    {
+        clock_delay(x->f_output_clock, x->f_output);
+    }
+}
 
 static void hoa_meter_tick(t_hoa_meter *x)
 {
-    if(x->f_vector_type == hoa_sym_both)
-        x->f_vector->process(x->f_signals, x->f_vector_coords);
-    else if(x->f_vector_type == hoa_sym_velocity)
-        x->f_vector->processVelocity(x->f_signals, x->f_vector_coords);
-    else if(x->f_vector_type == hoa_sym_energy)
-        x->f_vector->processEnergy(x->f_signals, x->f_vector_coords + 2);
-
-    x->f_meter->tick(ulong(1000 / x->f_interval));
-    ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
-    ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-    ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
-    ebox_redraw((t_ebox *)x);
+    const ulong nplws = x->f_meter->getNumberOfPlanewaves();
+    if(!x->f_output)
+    {
+        hoa_meter_process(x, x->f_interval);
+    }
+
+    bool changed = false;
+    for(ulong i = 0; i < nplws; i++)
+    {
+        if(hoa_meter_getleds(x, i) != x->f_leds[i])
+        {
+            ebox_invalidate_layer((t_ebox *)x, hoa_meter_leds_layers[i]);
+            changed = true;
+        }
+    }
+    for(ulong i = 0; i < 4; i++)
+    {
+        if(hoa_meter_getpixel(x, x->f_vector_coords[i]) != x->f_vector_pixels[i])
+        {
+            ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
+            changed = true;
+            break;
+        }
+    }
+    if(changed)
+    {
+        hoa_frame_redraw((t_ebox *)x);
+    }
 
-    if (canvas_dspstate)
-        clock_delay(x->f_clock, x->f_interval);
 }
 
 static void hoa_meter_dsp(t_hoa_meter *x, t_object *dsp, short *count, double samplerate, long maxvectorsize, long flags)
 {
-    x->f_meter->setVectorSize(ulong(maxvectorsize));
+    x->f_meter->setVectorSize(1ul);
+    memset(x->f_snapshot->write(), 0, HOA_METER_SIZE * sizeof(t_sample));
+    if(x->f_scratch)
+    {
+        Signal<t_sample>::free(x->f_scratch);
+    }
+    x->f_scratch    = Signal<t_sample>::alloc(ulong(maxvectorsize * 4));
+    x->f_samplerate = samplerate;
+    x->f_ramp = 0;
     object_method(dsp, gensym("dsp_add"), x, (method)hoa_meter_perform, 0, NULL);
     x->f_startclock = 1;
+    if(x->f_output)
+    {
+        clock_delay(x->f_output_clock, x->f_output);
+    }
 }
 
 static void draw_background(t_hoa_meter *x,  t_object *view, t_rect *rect)
@@ -371,17 +640,20 @@ static void draw_leds(t_hoa_meter *x, t_object *view, t_rect *rect)
     const float height = 0.49 * rect->width / 17.;
     const float lwidth = height - pd_clip_min(360. / rect->width, 2.);
     t_matrix transform;
-    t_elayer *g = ebox_start_layer((t_ebox *)x,  hoa_sym_leds_layer, rect->width, rect->height);
+    t_rgba black = rgba_addContrast(x->f_color_bg, -HOA_CONTRAST_DARKER);
 
-    if(g)
+    for(ulong i = 0; i < x->f_meter->getNumberOfPlanewaves(); i++)
     {
-        t_rgba black = rgba_addContrast(x->f_color_bg, -HOA_CONTRAST_DARKER);
-        egraphics_matrix_init(&transform, 1, 0, 0, -1, rect->width * .5, rect->width * .5);
-        egraphics_set_matrix(g, &transform);
-        egraphics_rotate(g, HOA_PI2);
-
-        for(ulong i = 0; i < x->f_meter->getNumberOfPlanewaves(); i++)
+        t_elayer *g = ebox_start_layer((t_ebox *)x,  hoa_meter_leds_layers[i], rect->width, rect->height);
+        if(g)
         {
+            const long leds = hoa_meter_getleds(x, i);
+            x->f_leds[i] = leds;
+
+            egraphics_matrix_init(&transform, 1, 0, 0, -1, rect->width * .5, rect->width * .5);
+            egraphics_set_matrix(g, &transform);
+            egraphics_rotate(g, HOA_PI2);
+
             width = x->f_meter->getPlanewaveWidth(i) * 0.5f;
             angle = x->f_meter->getPlanewaveAzimuthMapped(i);
             if(x->f_clockwise == hoa_sym_clockwise)
@@ -389,11 +661,11 @@ static void draw_leds(t_hoa_meter *x, t_object *view, t_rect *rect)
             else
                 egraphics_rotate(g, angle);
 
-            float j = 12.f, dB = -39.f;
+            long j = 12;
             while(j > 0)
             {
                 float radius    = (j + 4.) * height;
-                if(x->f_meter->getPlanewaveEnergy(i) > dB)
+                if(12 - j < (leds & 15))
                 {
                     if(j > 9)
                         egraphics_set_color_rgba(g, &x->f_color_cold_signal);
@@ -403,43 +675,32 @@ static void draw_leds(t_hoa_meter *x, t_object *view, t_rect *rect)
                         egraphics_set_color_rgba(g, &x->f_color_warm_signal);
                     else
                         egraphics_set_color_rgba(g, &x->f_color_hot_signal);
-
-                    egraphics_set_line_width(g, lwidth);
-                    egraphics_arc(g, 0., 0., radius,  width, 3.f * width);
-                    egraphics_stroke(g);
                 }
-                else if(j)
+                else
                 {
                     egraphics_set_color_rgba(g, &black);
-                    egraphics_set_line_width(g, lwidth);
-                    egraphics_arc(g, 0., 0., radius,  width, 3.f * width);
-                    egraphics_stroke(g);
                 }
-                j--; dB += 3.;
+                egraphics_set_line_width(g, lwidth);
+                egraphics_arc(g, 0., 0., radius,  width, 3.f * width);
+                egraphics_stroke(g);
+                j--;
             }
-            if(x->f_meter->getPlanewaveOverLed(i))
+            if(leds & 16)
             {
                 egraphics_set_color_rgba(g, &x->f_color_over_signal);
-                egraphics_set_line_width(g, lwidth);
-                egraphics_arc(g, 0., 0., 4. * height,  width, 3.f * width);
-                egraphics_stroke(g);
             }
             else
             {
                 egraphics_set_color_rgba(g, &black);
-                egraphics_set_line_width(g, lwidth);
-                egraphics_arc(g, 0., 0., 4. * height,  width, 3.f * width);
-                egraphics_stroke(g);
             }
+            egraphics_set_line_width(g, lwidth);
+            egraphics_arc(g, 0., 0., 4. * height,  width, 3.f * width);
+            egraphics_stroke(g);
 
-            if(x->f_clockwise == hoa_sym_clockwise)
-                egraphics_rotate(g, angle);
-            else
-                egraphics_rotate(g, -angle);
+            ebox_end_layer((t_ebox*)x,  hoa_meter_leds_layers[i]);
         }
-        ebox_end_layer((t_ebox*)x,  hoa_sym_leds_layer);
+        ebox_paint_layer((t_ebox *)x, hoa_meter_leds_layers[i], 0., 0.);
     }
-    ebox_paint_layer((t_ebox *)x, hoa_sym_leds_layer, 0., 0.);
 }
 
 static void draw_vectors(t_hoa_meter *x, t_object *view, t_rect *rect)
@@ -450,6 +711,10 @@ static void draw_vectors(t_hoa_meter *x, t_object *view, t_rect *rect)
 
     if(g)
     {
+        for(ulong i = 0; i < 4; i++)
+        {
+            x->f_vector_pixels[i] = hoa_meter_getpixel(x, x->f_vector_coords[i]);
+        }
         egraphics_matrix_init(&transform, 1, 0, 0, -1, rect->width / 2., rect->width / 2.);
         egraphics_set_matrix(g, &transform);
         size = 1. / 64. * rect->width;
@@ -501,6 +766,12 @@ static void hoa_meter_paint(t_hoa_meter *x, t_object *view)
     t_rect rect;
     ebox_get_rect_for_view((t_ebox *)x, &rect);
 
+    if(x->f_center != rect.width * .5)
+    {
+        hoa_meter_invalidate_leds(x);
+        ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
+        ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
+    }
     x->f_center = rect.width * .5;
     x->f_radius = x->f_center * 0.95;
     x->f_radius_center = x->f_radius / 5.;
@@ -512,11 +783,17 @@ static void hoa_meter_paint(t_hoa_meter *x, t_object *view)
 
 static void hoa_meter_free(t_hoa_meter *x)
 {
+    hoa_frame_unregister((t_ebox *)x);
+    clock_free(x->f_output_clock);
     ebox_free((t_ebox *)x);
-    clock_free(x->f_clock);
     delete x->f_meter;
     delete x->f_vector;
-    Signal<t_sample>::free(x->f_signals);
+    delete x->f_snapshot;
+    Signal<t_sample>::free(x->f_axes);
+    if(x->f_scratch)
+    {
+        Signal<t_sample>::free(x->f_scratch);
+    }
 }
 
 static void *hoa_meter_new(t_symbol *s, int argc, t_atom *argv)
@@ -530,13 +807,24 @@ static void *hoa_meter_new(t_symbol *s, int argc, t_atom *argv)
         x->f_ramp = 0;
         x->f_meter  = new Meter<Hoa2d, t_sample>(4);
         x->f_vector = new Vector<Hoa2d, t_sample>(4);
-        x->f_signals = Signal<t_sample>::alloc(HOA_MAX_PLANEWAVES * HOA_MAXBLKSIZE);
+        x->f_snapshot   = new HoaTripleBuffer(HOA_METER_SIZE);
+        x->f_axes       = Signal<t_sample>::alloc(HOA_MAX_PLANEWAVES * 3);
+        x->f_scratch    = NULL;
+        x->f_samplerate = sys_getsr();
         x->f_meter->computeRendering();
         x->f_vector->computeRendering();
+        hoa_meter_axes(x->f_vector, x->f_axes);
 
-        x->f_clock = clock_new(x,(t_method)hoa_meter_tick);
+        for(ulong i = 0; i < HOA_MAX_PLANEWAVES; i++)
+        {
+            x->f_leds[i] = -1;
+        }
+        hoa_frame_register((t_ebox *)x, (t_method)hoa_meter_tick, &x->f_interval);
         x->f_startclock = 0;
+        x->f_output = 0;
+        x->f_output_clock = clock_new(x, (t_method)hoa_meter_output);
         eobj_dspsetup((t_ebox *)x, long(x->f_meter->getNumberOfPlanewaves()), 0);
+        x->f_out = listout(x);
 
         flags = 0
         | EBOX_GROWLINK
@@ -558,6 +846,13 @@ extern "C" void setup_hoa0x2e2d0x2emeter_tilde(void)
 {
     t_eclass *c;
 
+    char name[MAXPDSTRING];
+    for(ulong i = 0; i < HOA_MAX_PLANEWAVES; i++)
+    {
+        sprintf(name, "leds_layer%lu", i);
+        hoa_meter_leds_layers[i] = gensym(name);
+    }
+
     c = eclass_new("hoa.2d.meter~", (method)hoa_meter_new, (method)hoa_meter_free, (short)sizeof(t_hoa_meter), CLASS_NOINLET, A_GIMME, 0);
     class_addcreator((t_newmethod)hoa_meter_new, gensym("hoa.meter~"), A_GIMME, 0);
 
@@ -624,6 +919,14 @@ extern "C" void setup_hoa0x2e2d0x2emeter_tilde(void)
     CLASS_ATTR_SAVE                 (c, "interval", 1);
     CLASS_ATTR_STYLE                (c, "interval", 1, "number");
 
+    CLASS_ATTR_LONG                 (c, "output", 0, t_hoa_meter, f_output);
+    CLASS_ATTR_ACCESSORS            (c, "output", NULL, output_set);
+    CLASS_ATTR_ORDER                (c, "output", 0, "6");
+    CLASS_ATTR_LABEL                (c, "output", 0, "Data Output Interval (in ms, 0 = off)");
+    CLASS_ATTR_DEFAULT              (c, "output", 0, "0");
+    CLASS_ATTR_SAVE                 (c, "output", 1);
+    CLASS_ATTR_STYLE                (c, "output", 1, "number");
+
     CLASS_ATTR_RGBA					(c, "bgcolor", 0, t_hoa_meter, f_color_bg);
     CLASS_ATTR_CATEGORY				(c, "bgcolor", 0, "Color");
     CLASS_ATTR_STYLE				(c, "bgcolor", 0, "rgba");
@@ -689,7 +992,10 @@ typedef struct  _hoa_meter_3d
     t_edspbox               f_box;
     Meter<Hoa3d, t_sample>* f_meter;
     Vector<Hoa3d, t_sample>*f_vector;
-    t_sample*               f_signals;
+    HoaTripleBuffer*        f_snapshot;
+    t_sample*               f_axes;
+    t_sample*               f_scratch;
+    double                  f_samplerate;
     t_sample                f_vector_coords[6];
     long                    f_ramp;
     int                     f_startclock;
@@ -713,7 +1019,6 @@ typedef struct  _hoa_meter_3d
     double                  f_center;
     double                  f_radius_center;
 
-    t_clock*                f_clock;
     void*                   f_attrs;
 
 } t_hoa_meter_3d;
@@ -792,12 +1097,13 @@ static t_pd_err channels_3d_set(t_hoa_meter_3d *x, void *attr, int argc, t_atom
 
                 x->f_meter->computeRendering();
                 x->f_vector->computeRendering();
+                hoa_meter_axes(x->f_vector, x->f_axes);
                 eobj_resize_inputs((t_ebox *)x, long(x->f_meter->getNumberOfPlanewaves()));
 
                 ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
                 ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
                 ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-                ebox_redraw((t_ebox *)x);
+                hoa_frame_redraw((t_ebox *)x);
                 canvas_resume_dsp(dspState);
             }
         }
@@ -848,11 +1154,12 @@ static t_pd_err angles_3d_set(t_hoa_meter_3d *x, void *attr, int argc, t_atom *a
 
         x->f_meter->computeRendering();
         x->f_vector->computeRendering();
+        hoa_meter_axes(x->f_vector, x->f_axes);
 
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
 
     return 0;
@@ -901,11 +1208,12 @@ static t_pd_err offset_3d_set(t_hoa_meter_3d *x, void *attr, int argc, t_atom *a
 
         x->f_meter->computeRendering();
         x->f_vector->computeRendering();
+        hoa_meter_axes(x->f_vector, x->f_axes);
 
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
 
     }
 
@@ -939,7 +1247,7 @@ static t_pd_err vectors_3d_set(t_hoa_meter_3d *x, void *attr, int argc, t_atom *
                 x->f_vector_type = hoa_sym_none;
         }
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
     return 0;
 }
@@ -966,7 +1274,7 @@ static t_pd_err rotation_3d_set(t_hoa_meter_3d *x, void *attr, int argc, t_atom
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
     return 0;
 }
@@ -1012,45 +1320,47 @@ static t_pd_err view_3d_set(t_hoa_meter_3d *x, void *attr, int argc, t_atom *arg
 
 static void hoa_meter_3d_perform(t_hoa_meter_3d *x, t_object *dsp, float **ins, long numins, float **outs, long no, long sampleframes, long f,void *up)
 {
-    for(int i = 0; i < numins; i++)
-    {
-        Signal<t_sample>::copy(ulong(sampleframes), ins[i], 1, x->f_signals+i, ulong(numins));
-    }
-    for(x->f_ramp = 0; x->f_ramp < sampleframes; x->f_ramp++)
-    {
-        x->f_meter->process(x->f_signals + numins * x->f_ramp);
-    }
+    hoa_meter_accumulate(x->f_snapshot, x->f_axes, x->f_scratch, ins, numins, sampleframes, x->f_ramp, long(x->f_samplerate * double(x->f_interval) * 0.001), x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_velocity);
     if(x->f_startclock)
     {
         x->f_startclock = 0;
-        clock_delay(x->f_clock,0);
+        hoa_frame_start();
     }
 
 }
 
 static void hoa_meter_3d_dsp(t_hoa_meter_3d *x, t_object *dsp, short *count, double samplerate, long maxvectorsize, long flags)
 {
-    x->f_meter->setVectorSize(ulong(maxvectorsize));
+    x->f_meter->setVectorSize(1ul);
+    memset(x->f_snapshot->write(), 0, HOA_METER_SIZE * sizeof(t_sample));
+    if(x->f_scratch)
+    {
+        Signal<t_sample>::free(x->f_scratch);
+    }
+    x->f_scratch    = Signal<t_sample>::alloc(ulong(maxvectorsize * 4));
+    x->f_samplerate = samplerate;
+    x->f_ramp = 0;
     object_method(dsp, gensym("dsp_add"), x, (method)hoa_meter_3d_perform, 0, NULL);
     x->f_startclock = 1;
 }
 
 static void hoa_meter_3d_tick(t_hoa_meter_3d *x)
 {
-    if(x->f_vector_type == hoa_sym_both)
-        x->f_vector->process(x->f_signals, x->f_vector_coords);
-    else if(x->f_vector_type == hoa_sym_velocity)
-        x->f_vector->processVelocity(x->f_signals, x->f_vector_coords);
-    else if(x->f_vector_type == hoa_sym_energy)
-        x->f_vector->processEnergy(x->f_signals, x->f_vector_coords + 3);
+    const ulong nplws = x->f_meter->getNumberOfPlanewaves();
+    t_sample const* snap = hoa_meter_read(x->f_snapshot);
+    if(snap)
+    {
+        x->f_meter->process(snap + HOA_METER_PEAKS);
+        const bool velocity = x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_velocity;
+        const bool energy   = x->f_vector_type == hoa_sym_both || x->f_vector_type == hoa_sym_energy;
+        hoa_meter_vectors(snap, x->f_axes, nplws, 3, velocity ? x->f_vector_coords : NULL, energy ? x->f_vector_coords + 3 : NULL);
+    }
 
     x->f_meter->tick(ulong((1000.f / (float)x->f_interval)));
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-    ebox_redraw((t_ebox *)x);
+    hoa_frame_redraw((t_ebox *)x);
 
-    if (canvas_dspstate)
-        clock_delay(x->f_clock, x->f_interval);
 }
 
 static void draw_3d_background(t_hoa_meter_3d *x,  t_object *view, t_rect *rect)
@@ -1387,11 +1697,16 @@ static void hoa_meter_3d_paint(t_hoa_meter_3d *x, t_object *view)
 
 static void hoa_meter_3d_free(t_hoa_meter_3d *x)
 {
+    hoa_frame_unregister((t_ebox *)x);
     ebox_free((t_ebox *)x);
-    clock_free(x->f_clock);
     delete x->f_meter;
     delete x->f_vector;
-    Signal<t_sample>::free(x->f_signals);
+    delete x->f_snapshot;
+    Signal<t_sample>::free(x->f_axes);
+    if(x->f_scratch)
+    {
+        Signal<t_sample>::free(x->f_scratch);
+    }
 }
 
 static void *hoa_meter_3d_new(t_symbol *s, int argc, t_atom *argv)
@@ -1405,11 +1720,15 @@ static void *hoa_meter_3d_new(t_symbol *s, int argc, t_atom *argv)
         x->f_ramp = 0;
         x->f_meter  = new Meter<Hoa3d, t_sample>(4);
         x->f_vector = new Vector<Hoa3d, t_sample>(4);
-        x->f_signals = Signal<t_sample>::alloc(HOA_MAX_PLANEWAVES * HOA_MAXBLKSIZE);
+        x->f_snapshot   = new HoaTripleBuffer(HOA_METER_SIZE);
+        x->f_axes       = Signal<t_sample>::alloc(HOA_MAX_PLANEWAVES * 3);
+        x->f_scratch    = NULL;
+        x->f_samplerate = sys_getsr();
 
         x->f_meter->computeRendering();
         x->f_vector->computeRendering();
-        x->f_clock = clock_new(x,(t_method)hoa_meter_3d_tick);
+        hoa_meter_axes(x->f_vector, x->f_axes);
+        hoa_frame_register((t_ebox *)x, (t_method)hoa_meter_3d_tick, &x->f_interval);
         x->f_startclock = 0;
         eobj_dspsetup((t_ebox *)x, long(x->f_meter->getNumberOfPlanewaves()), 0);
 
@@ -1459,11 +1778,12 @@ static void hoa_meter_3d_beatles(t_hoa_meter_3d *x)
 
     x->f_meter->computeRendering();
     x->f_vector->computeRendering();
+    hoa_meter_axes(x->f_vector, x->f_axes);
 
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_background_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_leds_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_vector_layer);
-    ebox_redraw((t_ebox *)x);
+    hoa_frame_redraw((t_ebox *)x);
 
     eobj_resize_inputs((t_ebox *)x, (long)x->f_meter->getNumberOfPlanewaves());
     canvas_resume_dsp(dspState);
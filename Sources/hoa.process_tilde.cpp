@@ -6,6 +6,7 @@
 
 #include "../hoa.library.hpp"
 #include "../ThirdParty/HoaLibrary/Sources/Hoa.hpp"
+#include <chrono>
 using namespace hoa;
 
 class ProcessInstance
@@ -20,6 +21,15 @@ class ProcessInstance
     vector<t_hoa_out*>          m_outs_extra;
     vector<t_hoa_out_tilde*>    m_outs_sig;
     vector<t_hoa_out_tilde*>    m_outs_extra_sig;
+    vector< vector<t_hoa_in*> > m_ins_extra_table;
+    vector<t_sample*>           m_ins_multi;
+    vector<t_sample*>           m_outs_multi;
+    
+    t_object*                   m_switch;
+    ulong                       m_nticks;
+    double                      m_sum;
+    double                      m_max;
+    ulong                       m_histogram[64];
     
 private:
     
@@ -85,6 +95,40 @@ private:
         }
     }
     
+    void buildRoutingTable()
+    {
+        m_ins_extra_table.clear();
+        m_ins_extra_table.resize(getMaximumInputExtraIndex());
+        for(ulong i = 0; i < m_ins_extra.size(); i++)
+        {
+            m_ins_extra_table[size_t(m_ins_extra[i]->f_extra - 1)].push_back(m_ins_extra[i]);
+        }
+    }
+    
+    //! Records the duration of a tick in microseconds.
+    /** The histogram has 64 bins spaced by a quarter of an octave from 0.5 microseconds, it's used to evaluate the percentiles.
+     */
+    inline void record(const double time) noexcept
+    {
+        m_nticks++;
+        m_sum += time;
+        if(time > m_max)
+        {
+            m_max = time;
+        }
+        const long bin = (time > 0.5) ? long(4. * log2(time * 2.)) : 0;
+        m_histogram[bin < 63 ? bin : 63]++;
+    }
+    
+    inline vector<t_hoa_in*> const* getExtraInputs(ulong extra) const noexcept
+    {
+        if(extra && extra <= m_ins_extra_table.size())
+        {
+            return &m_ins_extra_table[extra - 1];
+        }
+        return NULL;
+    }
+    
     static void thisprocess_init(t_hoa_thisprocess* thisprocess, int argc, t_atom* argv, int nattrs, t_atom* attrs)
     {
         if(thisprocess)
@@ -132,6 +176,8 @@ public:
                     t_atom* attrs)
     {
         m_canvas = NULL;
+        m_switch = NULL;
+        clearTimes();
         t_atom av[6];
         atom_setlong(av, 1);
         atom_setlong(av+1, 1);
@@ -176,6 +222,7 @@ public:
             }
             canvas_loadbang(m_canvas);
             getIos(m_canvas);
+            buildRoutingTable();
         }
     }
     
@@ -190,6 +237,61 @@ public:
         m_outs_extra.clear();
         m_outs_sig.clear();
         m_outs_extra_sig.clear();
+        m_ins_extra_table.clear();
+        m_ins_multi.clear();
+        m_outs_multi.clear();
+    }
+    
+    //! Sets the switch~ of the private canvas that holds the instance, its DSP chain then runs and is timed separately.
+    inline void setSwitch(t_object* sw) noexcept
+    {
+        m_switch = sw;
+        clearTimes();
+    }
+    
+    inline bool isProfiling() const noexcept
+    {
+        return m_switch;
+    }
+    
+    inline void run() noexcept
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        pd_bang((t_pd *)m_switch);
+        record(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    
+    inline void clearTimes() noexcept
+    {
+        m_nticks = 0ul;
+        m_sum = 0.;
+        m_max = 0.;
+        memset(m_histogram, 0, 64 * sizeof(ulong));
+    }
+    
+    inline double getMeanTime() const noexcept
+    {
+        return m_nticks ? m_sum / double(m_nticks) : 0.;
+    }
+    
+    inline double getMaximumTime() const noexcept
+    {
+        return m_max;
+    }
+    
+    double getPercentileTime(const double percentile) const noexcept
+    {
+        const double limit = percentile * double(m_nticks);
+        ulong count = 0ul;
+        for(ulong i = 0; i < 64; i++)
+        {
+            count += m_histogram[i];
+            if(count && double(count) >= limit)
+            {
+                return min(m_max, 0.5 * pow(2., double(i + 1) * 0.25));
+            }
+        }
+        return m_max;
     }
     
     inline void show() const noexcept
@@ -208,11 +310,12 @@ public:
     
     inline void sendBang(ulong extra) const noexcept
     {
-        for(ulong i = 0; i < m_ins_extra.size(); i++)
+        vector<t_hoa_in*> const* ins = getExtraInputs(extra);
+        if(ins)
         {
-            if(ulong(m_ins_extra[i]->f_extra) == extra)
+            for(ulong i = 0; i < ins->size(); i++)
             {
-                pd_bang((t_pd *)m_ins_extra[i]);
+                pd_bang((t_pd *)(*ins)[i]);
             }
         }
     }
@@ -227,11 +330,12 @@ public:
     
     inline void sendFloat(ulong extra, const float f) const noexcept
     {
-        for(ulong i = 0; i < m_ins_extra.size(); i++)
+        vector<t_hoa_in*> const* ins = getExtraInputs(extra);
+        if(ins)
         {
-            if(ulong(m_ins_extra[i]->f_extra) == extra)
+            for(ulong i = 0; i < ins->size(); i++)
             {
-                pd_float((t_pd *)m_ins_extra[i], f);
+                pd_float((t_pd *)(*ins)[i], f);
             }
         }
     }
@@ -246,11 +350,12 @@ public:
     
     inline void sendSymbol(ulong extra, t_symbol* s) const noexcept
     {
-        for(ulong i = 0; i < m_ins_extra.size(); i++)
+        vector<t_hoa_in*> const* ins = getExtraInputs(extra);
+        if(ins)
         {
-            if(ulong(m_ins_extra[i]->f_extra) == extra)
+            for(ulong i = 0; i < ins->size(); i++)
             {
-                pd_symbol((t_pd *)m_ins_extra[i], s);
+                pd_symbol((t_pd *)(*ins)[i], s);
             }
         }
     }
@@ -265,11 +370,12 @@ public:
     
     inline void sendList(ulong extra, t_symbol* s, int argc, t_atom* argv) const noexcept
     {
-        for(ulong i = 0; i < m_ins_extra.size(); i++)
+        vector<t_hoa_in*> const* ins = getExtraInputs(extra);
+        if(ins)
         {
-            if(ulong(m_ins_extra[i]->f_extra) == extra)
+            for(ulong i = 0; i < ins->size(); i++)
             {
-                pd_list((t_pd *)m_ins_extra[i], s, argc, argv);
+                pd_list((t_pd *)(*ins)[i], s, argc, argv);
             }
         }
     }
@@ -284,11 +390,12 @@ public:
     
     inline void sendAnything(ulong extra, t_symbol* s, int argc, t_atom* argv) const noexcept
     {
-        for(ulong i = 0; i < m_ins_extra.size(); i++)
+        vector<t_hoa_in*> const* ins = getExtraInputs(extra);
+        if(ins)
         {
-            if(ulong(m_ins_extra[i]->f_extra) == extra)
+            for(ulong i = 0; i < ins->size(); i++)
             {
-                pd_typedmess((t_pd *)m_ins_extra[i], s, argc, argv);
+                pd_typedmess((t_pd *)(*ins)[i], s, argc, argv);
             }
         }
     }
@@ -422,6 +529,41 @@ public:
         }
         return false;
     }
+    
+    bool prepareDsp(vector<t_sample*>& ins, vector<t_sample*>& ixtra, vector<t_sample*>& outs, vector<t_sample*>& oxtra)
+    {
+        m_ins_multi     = ins;
+        m_outs_multi    = outs;
+        for(size_t i = 0; i < m_ins_sig.size(); i++)
+        {
+            m_ins_sig[i]->f_signals     = m_ins_multi.empty() ? NULL : &m_ins_multi[0];
+            m_ins_sig[i]->f_nchannels   = int(m_ins_multi.size());
+        }
+        for(size_t i = 0; i < m_ins_extra_sig.size(); i++)
+        {
+            if(ulong(m_ins_extra_sig[i]->f_extra) > ixtra.size() || !ixtra[size_t(m_ins_extra_sig[i]->f_extra-1)])
+            {
+                bug("process don't have input signal extra %i.", m_ins_extra_sig[i]->f_extra);
+                return true;
+            }
+            m_ins_extra_sig[i]->f_signal = ixtra[size_t(m_ins_extra_sig[i]->f_extra-1)];
+        }
+        for(size_t i = 0; i < m_outs_sig.size(); i++)
+        {
+            m_outs_sig[i]->f_signals    = m_outs_multi.empty() ? NULL : &m_outs_multi[0];
+            m_outs_sig[i]->f_nchannels  = int(m_outs_multi.size());
+        }
+        for(size_t i = 0; i < m_outs_extra_sig.size(); i++)
+        {
+            if(ulong(m_outs_extra_sig[i]->f_extra) > oxtra.size() || !oxtra[size_t(m_outs_extra_sig[i]->f_extra-1)])
+            {
+                bug("process don't have output signal extra %i.", m_outs_extra_sig[i]->f_extra);
+                return true;
+            }
+            m_outs_extra_sig[i]->f_signal = oxtra[size_t(m_outs_extra_sig[i]->f_extra-1)];
+        }
+        return false;
+    }
 };
 
 typedef struct _hoa_process
@@ -429,22 +571,98 @@ typedef struct _hoa_process
     t_edspobj               f_obj;
     t_canvas*               f_global;
     t_object*               f_switch;
+    vector<t_canvas*>       f_canvases;
+    vector<t_object*>       f_switches;
     t_symbol*               f_domain;
     t_symbol*               f_dimension;
     vector<ProcessInstance*>f_instances;
+    ulong                   f_nchannels;
+    bool                    f_multichannel;
+    bool                    f_profiling;
+    t_outlet*               f_info;
     long                    f_target;
     vector<t_sample*>       f_outlets_signals;
+    vector<t_sample*>       f_inlets_signals;
+    vector<t_sample*>       f_inlets_history;
+    vector<t_sample*>       f_outlets_history;
+    vector<ulong>           f_dispatched;
     bool                    f_have_ins;
     
+    long                    f_blocksize;
+    long                    f_overlap;
+    long                    f_upsample;
+    long                    f_window;
+    long                    f_hop;
+    long                    f_phase;
+    long                    f_applied[3];
+    
     static const long target_all  = -1;
     
 } t_hoa_process;
 
 static t_eclass *hoa_process_class;
 
+//! Creates a hidden canvas with a switch~, its DSP chain only runs when the switch~ is banged. The canvas is private to hoa.process~ and never belongs to a patch.
+static t_canvas* hoa_process_canvas_new(t_object** sw)
+{
+    *sw = NULL;
+    t_canvas* canvas = canvas_new(NULL, gensym(""), 0, NULL);
+    if(canvas)
+    {
+        pd_popsym((t_pd *)canvas);
+        canvas_vis(canvas, 0);
+        t_atom av[3];
+        atom_setlong(av, 10); atom_setlong(av+1, 10); atom_setsym(av+2, gensym("switch~"));
+        pd_typedmess((t_pd *)canvas, gensym("obj"), 3, av);
+        if(canvas->gl_list && canvas->gl_list->g_pd->c_name == gensym("block~"))
+        {
+            *sw = (t_object *)canvas->gl_list;
+        }
+    }
+    return canvas;
+}
+
+//! Returns the canvas that will hold the next instance, with @cputime each instance gets its own canvas and switch~ so the patch of the instance is never modified.
+static t_canvas* hoa_process_parent(t_hoa_process *x)
+{
+    if(x->f_profiling)
+    {
+        t_object* sw = NULL;
+        t_canvas* canvas = hoa_process_canvas_new(&sw);
+        if(canvas && sw)
+        {
+            x->f_canvases.push_back(canvas);
+            x->f_switches.push_back(sw);
+            return canvas;
+        }
+        if(canvas)
+        {
+            canvas_free(canvas);
+        }
+        return NULL;
+    }
+    return x->f_global;
+}
+
+//! Runs the instances once, through their own switch~ when they are profiled, otherwise through the global one.
+static inline void hoa_process_run(t_hoa_process *x)
+{
+    if(x->f_profiling)
+    {
+        for(ulong i = 0; i < x->f_instances.size(); i++)
+        {
+            x->f_instances[i]->run();
+        }
+    }
+    else
+    {
+        pd_bang((t_pd *)x->f_switch);
+    }
+}
+
 static void hoa_process_perform(t_hoa_process *x, t_object *dsp, float **inps, long ni, float **outs, long nouts, long sampleframe, long f,void *up)
 {
-    pd_bang((t_pd *)x->f_switch);
+    hoa_process_run(x);
     for(int i = 0; i < nouts; i++)
     {
         memcpy(outs[i], x->f_outlets_signals[size_t(i)], size_t(sampleframe) * sizeof(t_sample));
@@ -453,6 +671,89 @@ static void hoa_process_perform(t_hoa_process *x, t_object *dsp, float **inps, l
 }
 
 
+//! Runs the instances with their own block size, overlap and upsampling.
+/** As with Pd's block~, the input is upsampled by repeating the samples and the output is decimated without filtering, so a patcher that upsamples should filter its signals itself. The overlapping outputs are summed and divided by the overlap, so a patcher that passes its input through gives it back at unity gain.
+ */
+static void hoa_process_perform_reblock(t_hoa_process *x, t_object *dsp, float **inps, long ni, float **outs, long nouts, long sampleframe, long f,void *up)
+{
+    const long window   = x->f_window;
+    const long factor   = x->f_upsample;
+    const t_sample gain = t_sample(x->f_hop) / t_sample(window);
+    long pos = 0;
+    while(pos < sampleframe)
+    {
+        const long n = min(sampleframe - pos, x->f_hop - x->f_phase);
+        for(long i = 0; i < ni; i++)
+        {
+            t_sample* history = x->f_inlets_history[size_t(i)];
+            memmove(history, history + n, size_t(window - n) * sizeof(t_sample));
+            memcpy(history + window - n, inps[i] + pos, size_t(n) * sizeof(t_sample));
+        }
+        for(long i = 0; i < nouts; i++)
+        {
+            t_sample* history = x->f_outlets_history[size_t(i)];
+            memcpy(outs[i] + pos, history, size_t(n) * sizeof(t_sample));
+            memmove(history, history + n, size_t(window - n) * sizeof(t_sample));
+            memset(history + window - n, 0, size_t(n) * sizeof(t_sample));
+        }
+        pos         += n;
+        x->f_phase  += n;
+        
+        if(x->f_phase == x->f_hop)
+        {
+            x->f_phase = 0;
+            for(long i = 0; i < ni; i++)
+            {
+                t_sample const* history = x->f_inlets_history[size_t(i)];
+                t_sample* signal        = x->f_inlets_signals[size_t(i)];
+                for(long j = 0; j < window; j++)
+                {
+                    for(long k = 0; k < factor; k++)
+                    {
+                        signal[j * factor + k] = history[j];
+                    }
+                }
+            }
+            hoa_process_run(x);
+            for(long i = 0; i < nouts; i++)
+            {
+                t_sample* history   = x->f_outlets_history[size_t(i)];
+                t_sample* signal    = x->f_outlets_signals[size_t(i)];
+                for(long j = 0; j < window; j++)
+                {
+                    history[j] += signal[j * factor] * gain;
+                }
+                memset(signal, 0, size_t(window * factor) * sizeof(t_sample));
+            }
+        }
+    }
+}
+
+static long hoa_process_powerof2(long n)
+{
+    long p = 1;
+    while(p * 2 <= n)
+    {
+        p *= 2;
+    }
+    return p;
+}
+
+static t_sample* hoa_process_getinput(t_hoa_process *x, long index, bool reblock)
+{
+    if(reblock)
+    {
+        while(long(x->f_inlets_signals.size()) <= index)
+        {
+            x->f_inlets_signals.push_back(Signal<t_sample>::alloc(HOA_MAXBLKSIZE));
+            x->f_inlets_history.push_back(Signal<t_sample>::alloc(HOA_MAXBLKSIZE));
+        }
+        memset(x->f_inlets_history[size_t(index)], 0, HOA_MAXBLKSIZE * sizeof(t_sample));
+        return x->f_inlets_signals[size_t(index)];
+    }
+    return eobj_getsignalinput(x, index);
+}
+
 static void hoa_process_dsp(t_hoa_process *x, t_object *dsp, short *count, double samplerate, long maxvectorsize, long flags)
 {
     if(!x->f_global && !x->f_switch)
@@ -469,9 +770,35 @@ static void hoa_process_dsp(t_hoa_process *x, t_object *dsp, short *count, doubl
     ulong max_sig_ins_extra     = 0ul;
     ulong max_sig_outs_extra    = 0ul;
     
+    const long blocksize = x->f_blocksize ? x->f_blocksize : min(maxvectorsize * x->f_upsample, long(HOA_MAXBLKSIZE));
+    x->f_window = long(pd_clip_min(blocksize / x->f_upsample, 1));
+    x->f_hop    = long(pd_clip_min(x->f_window / x->f_overlap, 1));
+    x->f_phase  = 0;
+    const bool reblock = blocksize != maxvectorsize || x->f_overlap != 1 || x->f_upsample != 1;
+    
+    if(blocksize != x->f_applied[0] || x->f_overlap != x->f_applied[1] || x->f_upsample != x->f_applied[2])
+    {
+        t_atom av[3];
+        atom_setlong(av, blocksize); atom_setlong(av+1, x->f_overlap); atom_setlong(av+2, x->f_upsample);
+        pd_typedmess((t_pd *)x->f_switch, gensym("set"), 3, av);
+        for(size_t i = 0; i < x->f_switches.size(); i++)
+        {
+            pd_typedmess((t_pd *)x->f_switches[i], gensym("set"), 3, av);
+        }
+        x->f_applied[0] = blocksize; x->f_applied[1] = x->f_overlap; x->f_applied[2] = x->f_upsample;
+    }
+    
     for(ulong i = 0; i < x->f_outlets_signals.size(); i++)
     {
         memset(x->f_outlets_signals[i], 0, HOA_MAXBLKSIZE * sizeof(t_sample));
+        if(reblock)
+        {
+            if(x->f_outlets_history.size() <= i)
+            {
+                x->f_outlets_history.push_back(Signal<t_sample>::alloc(HOA_MAXBLKSIZE));
+            }
+            memset(x->f_outlets_history[i], 0, HOA_MAXBLKSIZE * sizeof(t_sample));
+        }
     }
     for(ulong i = 0; i < x->f_instances.size(); i++)
     {
@@ -482,40 +809,40 @@ static void hoa_process_dsp(t_hoa_process *x, t_object *dsp, short *count, doubl
     }
     if(have_sig_ins)
     {
-        for(ulong i = 0; i < x->f_instances.size(); i++)
+        for(ulong i = 0; i < x->f_nchannels; i++)
         {
-            ins.push_back(eobj_getsignalinput(x, long(i)));
+            ins.push_back(hoa_process_getinput(x, long(i), reblock));
         }
         for(ulong i = 0; i < max_sig_ins_extra; i++)
         {
-            ixtra.push_back(eobj_getsignalinput(x, long(i+x->f_instances.size())));
+            ixtra.push_back(hoa_process_getinput(x, long(i+x->f_nchannels), reblock));
         }
     }
     else
     {
-        for(ulong i = 0; i < x->f_instances.size(); i++)
+        for(ulong i = 0; i < x->f_nchannels; i++)
         {
             ins.push_back(NULL);
         }
         for(ulong i = 0; i < max_sig_ins_extra; i++)
         {
-            ixtra.push_back(eobj_getsignalinput(x, long(i)));
+            ixtra.push_back(hoa_process_getinput(x, long(i), reblock));
         }
     }
     if(have_sig_outs)
     {
-        for(ulong i = 0; i < x->f_instances.size(); i++)
+        for(ulong i = 0; i < x->f_nchannels; i++)
         {
             outs.push_back(x->f_outlets_signals[i]);
         }
         for(ulong i = 0; i < max_sig_outs_extra; i++)
         {
-            oxtra.push_back(x->f_outlets_signals[i+x->f_instances.size()]);
+            oxtra.push_back(x->f_outlets_signals[i+x->f_nchannels]);
         }
     }
     else
     {
-        for(ulong i = 0; i < x->f_instances.size(); i++)
+        for(ulong i = 0; i < x->f_nchannels; i++)
         {
             outs.push_back(NULL);
         }
@@ -524,16 +851,76 @@ static void hoa_process_dsp(t_hoa_process *x, t_object *dsp, short *count, doubl
             oxtra.push_back(x->f_outlets_signals[i]);
         }
     }
-    for(ulong i = 0; i < x->f_instances.size(); i++)
+    if(x->f_multichannel)
     {
-        if(!x->f_instances[i] || x->f_instances[i]->prepareDsp(ins[i], ixtra, outs[i], oxtra))
+        if(!have_sig_ins)
+            ins.clear();
+        if(!have_sig_outs)
+            outs.clear();
+        if(x->f_instances.empty() || !x->f_instances[0] || x->f_instances[0]->prepareDsp(ins, ixtra, outs, oxtra))
         {
             pd_error(x, "hoa.process~ : Error while compiling the dsp chain.");
             return;
         }
     }
+    else
+    {
+        for(ulong i = 0; i < x->f_instances.size(); i++)
+        {
+            if(!x->f_instances[i] || x->f_instances[i]->prepareDsp(ins[i], ixtra, outs[i], oxtra))
+            {
+                pd_error(x, "hoa.process~ : Error while compiling the dsp chain.");
+                return;
+            }
+        }
+    }
     mess0((t_pd *)x->f_global, gensym("dsp"));
-    object_method(dsp, gensym("dsp_add"), x, (method)hoa_process_perform, 0, NULL);
+    for(size_t i = 0; i < x->f_canvases.size(); i++)
+    {
+        mess0((t_pd *)x->f_canvases[i], gensym("dsp"));
+    }
+    if(reblock)
+    {
+        object_method(dsp, gensym("dsp_add"), x, (method)hoa_process_perform_reblock, 0, NULL);
+    }
+    else
+    {
+        object_method(dsp, gensym("dsp_add"), x, (method)hoa_process_perform, 0, NULL);
+    }
+}
+
+static t_pd_err hoa_process_blocksize_set(t_hoa_process *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        int dspState = canvas_suspend_dsp();
+        const long n = atom_getlong(argv);
+        x->f_blocksize = (n > 0) ? hoa_process_powerof2(pd_clip_max(n, HOA_MAXBLKSIZE)) : 0;
+        canvas_resume_dsp(dspState);
+    }
+    return 0;
+}
+
+static t_pd_err hoa_process_overlap_set(t_hoa_process *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        int dspState = canvas_suspend_dsp();
+        x->f_overlap = hoa_process_powerof2(pd_clip_minmax(atom_getlong(argv), 1, HOA_MAXBLKSIZE));
+        canvas_resume_dsp(dspState);
+    }
+    return 0;
+}
+
+static t_pd_err hoa_process_upsample_set(t_hoa_process *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        int dspState = canvas_suspend_dsp();
+        x->f_upsample = hoa_process_powerof2(pd_clip_minmax(atom_getlong(argv), 1, HOA_MAXBLKSIZE));
+        canvas_resume_dsp(dspState);
+    }
+    return 0;
 }
 
 static void hoa_process_click(t_hoa_process *x)
@@ -611,16 +998,131 @@ static void hoa_process_target(t_hoa_process *x, t_symbol* s, int argc, t_atom*
     }
 }
 
+static void hoa_process_send(ProcessInstance* instance, int argc, t_atom* argv)
+{
+    if(argc == 1 && atom_gettype(argv) == A_FLOAT)
+    {
+        instance->sendFloat(atom_getfloat(argv));
+    }
+    else if(argc == 1 && atom_gettype(argv) == A_SYM)
+    {
+        instance->sendSymbol(atom_getsym(argv));
+    }
+    else if(argc > 1)
+    {
+        instance->sendList(&s_list, argc, argv);
+    }
+}
+
+static void hoa_process_spread(t_hoa_process *x, t_symbol* s, int argc, t_atom* argv)
+{
+    const long ninstances = long(x->f_instances.size());
+    if(!argc || !argv || !ninstances)
+        return;
+    
+    if(atom_gettype(argv) == A_SYM && (atom_getsym(argv) == hoa_sym_harmonics || atom_getsym(argv) == hoa_sym_planewaves) && atom_getsym(argv) != x->f_domain)
+    {
+        pd_error(x, "hoa.process~ : spread %s doesn't match the domain %s.", atom_getsym(argv)->s_name, x->f_domain->s_name);
+        return;
+    }
+    if(atom_gettype(argv) == A_SYM && atom_getsym(argv) == hoa_sym_harmonics)
+    {
+        const int step = (x->f_dimension == hoa_sym_2d) ? 2 : 3;
+        for(int i = 1; i + step <= argc; i += step)
+        {
+            long index;
+            if(x->f_dimension == hoa_sym_2d)
+                index = long(Harmonic<Hoa2d, t_sample>::getIndex(abs(atom_getlong(argv+i)), atom_getlong(argv+i)));
+            else
+                index = long(Harmonic<Hoa3d, t_sample>::getIndex(atom_getlong(argv+i), atom_getlong(argv+i+1)));
+            if(index >= 0 && index < ninstances)
+            {
+                hoa_process_send(x->f_instances[size_t(index)], 1, argv+i+step-1);
+            }
+        }
+    }
+    else if(atom_gettype(argv) == A_SYM && atom_getsym(argv) == hoa_sym_planewaves)
+    {
+        for(int i = 1; i + 2 <= argc; i += 2)
+        {
+            const long index = atom_getlong(argv+i) - 1;
+            if(index >= 0 && index < ninstances)
+            {
+                hoa_process_send(x->f_instances[size_t(index)], 1, argv+i+1);
+            }
+        }
+    }
+    else
+    {
+        const int size = (argc > ninstances && argc % ninstances == 0) ? int(argc / ninstances) : 1;
+        for(long i = 0; i < ninstances && (i + 1) * size <= argc; i++)
+        {
+            hoa_process_send(x->f_instances[size_t(i)], size, argv + i * size);
+        }
+    }
+}
+
+static inline void hoa_process_count(t_hoa_process *x, ulong index)
+{
+    if(index < x->f_dispatched.size())
+    {
+        x->f_dispatched[index]++;
+    }
+}
+
+static void hoa_process_dispatched(t_hoa_process *x, t_symbol* s, int argc, t_atom* argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_SYM && atom_getsym(argv) == hoa_sym_clear)
+    {
+        std::fill(x->f_dispatched.begin(), x->f_dispatched.end(), 0ul);
+        return;
+    }
+    for(ulong i = 0; i < x->f_dispatched.size(); i++)
+    {
+        post("hoa.process~ : inlet %lu dispatched %lu messages.", i + 1, x->f_dispatched[i]);
+    }
+}
+
+//! Posts the times of the instances on the info outlet or clears them with "clear", only with @cputime.
+static void hoa_process_cputime(t_hoa_process *x, t_symbol* s, int argc, t_atom* argv)
+{
+    if(!x->f_profiling || !x->f_info)
+    {
+        pd_error(x, "hoa.process~ : cputime needs the attribute @cputime 1 at creation.");
+        return;
+    }
+    if(argc && argv && atom_gettype(argv) == A_SYM && atom_getsym(argv) == hoa_sym_clear)
+    {
+        for(ulong i = 0; i < x->f_instances.size(); i++)
+        {
+            x->f_instances[i]->clearTimes();
+        }
+    }
+    else
+    {
+        t_atom av[4];
+        for(ulong i = 0; i < x->f_instances.size(); i++)
+        {
+            atom_setlong(av, long(i + 1));
+            atom_setfloat(av+1, float(x->f_instances[i]->getMeanTime()));
+            atom_setfloat(av+2, float(x->f_instances[i]->getMaximumTime()));
+            atom_setfloat(av+3, float(x->f_instances[i]->getPercentileTime(0.99)));
+            outlet_anything(x->f_info, gensym("cputime"), 4, av);
+        }
+    }
+}
+
 static void hoa_process_bang(t_hoa_process *x)
 {
     ulong index = ulong(eobj_getproxy(x));
-    if(x->f_have_ins && ulong(index) < x->f_instances.size())
+    hoa_process_count(x, index);
+    if(x->f_have_ins && ulong(index) < x->f_nchannels)
     {
-        x->f_instances[index]->sendBang();
+        x->f_instances[x->f_multichannel ? 0 : index]->sendBang();
     }
     else
     {
-        ulong extra = x->f_have_ins ? index - x->f_instances.size() + 1 : index + 1;
+        ulong extra = x->f_have_ins ? index - x->f_nchannels + 1 : index + 1;
         if(x->f_target == _hoa_process::target_all)
         {
             for(ulong i = 0; i < x->f_instances.size(); i++)
@@ -638,13 +1140,14 @@ static void hoa_process_bang(t_hoa_process *x)
 static void hoa_process_float(t_hoa_process *x, float f)
 {
     ulong index = ulong(eobj_getproxy(x));
-    if(x->f_have_ins && ulong(index) < x->f_instances.size())
+    hoa_process_count(x, index);
+    if(x->f_have_ins && ulong(index) < x->f_nchannels)
     {
-        x->f_instances[index]->sendFloat(f);
+        x->f_instances[x->f_multichannel ? 0 : index]->sendFloat(f);
     }
     else
     {
-        ulong extra = x->f_have_ins ? index - x->f_instances.size() + 1 : index + 1;
+        ulong extra = x->f_have_ins ? index - x->f_nchannels + 1 : index + 1;
         if(x->f_target == _hoa_process::target_all)
         {
             for(ulong i = 0; i < x->f_instances.size(); i++)
@@ -662,13 +1165,14 @@ static void hoa_process_float(t_hoa_process *x, float f)
 static void hoa_process_symbol(t_hoa_process *x, t_symbol* s)
 {
     ulong index = ulong(eobj_getproxy(x));
-    if(x->f_have_ins && ulong(index) < x->f_instances.size())
+    hoa_process_count(x, index);
+    if(x->f_have_ins && ulong(index) < x->f_nchannels)
     {
-        x->f_instances[index]->sendSymbol(s);
+        x->f_instances[x->f_multichannel ? 0 : index]->sendSymbol(s);
     }
     else
     {
-        ulong extra = x->f_have_ins ? index - x->f_instances.size() + 1 : index + 1;
+        ulong extra = x->f_have_ins ? index - x->f_nchannels + 1 : index + 1;
         if(x->f_target == _hoa_process::target_all)
         {
             for(ulong i = 0; i < x->f_instances.size(); i++)
@@ -686,13 +1190,14 @@ static void hoa_process_symbol(t_hoa_process *x, t_symbol* s)
 static void hoa_process_list(t_hoa_process *x, t_symbol* s, int argc, t_atom* argv)
 {
     ulong index = ulong(eobj_getproxy(x));
-    if(x->f_have_ins && ulong(index) < x->f_instances.size())
+    hoa_process_count(x, index);
+    if(x->f_have_ins && ulong(index) < x->f_nchannels)
     {
-        x->f_instances[index]->sendList(s, argc, argv);
+        x->f_instances[x->f_multichannel ? 0 : index]->sendList(s, argc, argv);
     }
     else
     {
-        ulong extra = x->f_have_ins ? index - x->f_instances.size() + 1 : index + 1;
+        ulong extra = x->f_have_ins ? index - x->f_nchannels + 1 : index + 1;
         if(x->f_target == _hoa_process::target_all)
         {
             for(ulong i = 0; i < x->f_instances.size(); i++)
@@ -710,13 +1215,14 @@ static void hoa_process_list(t_hoa_process *x, t_symbol* s, int argc, t_atom* ar
 static void hoa_process_anything(t_hoa_process *x, t_symbol* s, int argc, t_atom* argv)
 {
     ulong index = ulong(eobj_getproxy(x));
-    if(x->f_have_ins && ulong(index) < x->f_instances.size())
+    hoa_process_count(x, index);
+    if(x->f_have_ins && ulong(index) < x->f_nchannels)
     {
-        x->f_instances[index]->sendAnything(s, argc, argv);
+        x->f_instances[x->f_multichannel ? 0 : index]->sendAnything(s, argc, argv);
     }
     else
     {
-        ulong extra = x->f_have_ins ? index - x->f_instances.size() + 1 : index + 1;
+        ulong extra = x->f_have_ins ? index - x->f_nchannels + 1 : index + 1;
         if(x->f_target == _hoa_process::target_all)
         {
             for(ulong i = 0; i < x->f_instances.size(); i++)
@@ -742,6 +1248,19 @@ static void hoa_process_free(t_hoa_process *x)
         }
     }
     x->f_outlets_signals.clear();
+    for(ulong i = 0 ; i < x->f_outlets_history.size(); i++)
+    {
+        Signal<t_sample>::free(x->f_outlets_history[i]);
+    }
+    x->f_outlets_history.clear();
+    for(ulong i = 0 ; i < x->f_inlets_signals.size(); i++)
+    {
+        Signal<t_sample>::free(x->f_inlets_signals[i]);
+        Signal<t_sample>::free(x->f_inlets_history[i]);
+    }
+    x->f_inlets_signals.clear();
+    x->f_inlets_history.clear();
+    x->f_dispatched.clear();
     for(ulong i = 0; i < x->f_instances.size(); i++)
     {
         if(x->f_instances[i])
@@ -753,6 +1272,12 @@ static void hoa_process_free(t_hoa_process *x)
     {
         canvas_free(x->f_global);
     }
+    for(size_t i = 0; i < x->f_canvases.size(); i++)
+    {
+        canvas_free(x->f_canvases[i]);
+    }
+    x->f_canvases.clear();
+    x->f_switches.clear();
     x->f_instances.clear();
     eobj_dspfree(x);
     canvas_resume_dsp(state);
@@ -771,41 +1296,72 @@ static void *hoa_process_new(t_symbol *s, int argc, t_atom *argv)
         x->f_global = NULL;
         x->f_switch = NULL;
         x->f_target = _hoa_process::target_all;
-        x->f_global = canvas_new(NULL, gensym(""), 0, NULL);
+        x->f_nchannels      = 0;
+        x->f_multichannel   = false;
+        x->f_profiling      = false;
+        x->f_info           = NULL;
+        x->f_blocksize  = 0;
+        x->f_overlap    = 1;
+        x->f_upsample   = 1;
+        x->f_window     = 0;
+        x->f_hop        = 0;
+        x->f_phase      = 0;
+        x->f_applied[0] = x->f_applied[1] = x->f_applied[2] = 0;
+        x->f_global = hoa_process_canvas_new(&x->f_switch);
         if(x->f_global)
         {
-            pd_popsym((t_pd *)x->f_global);
-            canvas_vis(x->f_global, 0);
-            t_atom av[3];
-            atom_setlong(av, 10); atom_setlong(av+1, 10);atom_setsym(av+2, gensym("switch~"));
-            pd_typedmess((t_pd *)x->f_global, gensym("obj"), 3, av);
-            if(x->f_global->gl_list->g_pd->c_name == gensym("block~"))
-            {
-                x->f_switch = (t_object *)x->f_global->gl_list;
-            }
             if(x->f_switch)
             {
                 long    narg = pd_clip_min(atoms_get_attributes_offset(argc - 3, argv + 3), 0);
                 t_atom* args = argv + 3;
                 long    natr = pd_clip_min(argc - narg - 3, 0);
                 t_atom* atrs = argv + 3 + narg;
+                if(atoms_has_attribute(int(natr), atrs, hoa_sym_multichannel))
+                {
+                    int     size = 0;
+                    t_atom* vals = NULL;
+                    atoms_get_attribute(int(natr), atrs, hoa_sym_multichannel, &size, &vals);
+                    if(size && vals)
+                    {
+                        x->f_multichannel = atom_getlong(vals) != 0;
+                        free(vals);
+                    }
+                    if(x->f_multichannel && !hoa_signal_setmultiout())
+                    {
+                        pd_error(x, "%s : multichannel mode requires Pure Data 0.54 or later.", s->s_name);
+                        x->f_multichannel = false;
+                    }
+                }
+                if(atoms_has_attribute(int(natr), atrs, hoa_sym_cputime))
+                {
+                    int     size = 0;
+                    t_atom* vals = NULL;
+                    atoms_get_attribute(int(natr), atrs, hoa_sym_cputime, &size, &vals);
+                    if(size && vals)
+                    {
+                        x->f_profiling = atom_getlong(vals) != 0;
+                        free(vals);
+                    }
+                }
                 if((s == hoa_sym_hoa_2d_process || s == hoa_sym_hoa_process) && atom_getsym(argv+2) != hoa_sym_planewaves)
                 {
                     x->f_domain     = hoa_sym_harmonics;
                     x->f_dimension  = hoa_sym_2d;
                     ulong order  = pd_clip_minmax(atom_getlong(argv), 1, 63);
-                    x->f_instances.resize(Harmonic<Hoa2d, t_sample>::getNumberOfHarmonics(order));
+                    x->f_nchannels  = Harmonic<Hoa2d, t_sample>::getNumberOfHarmonics(order);
+                    x->f_instances.resize(x->f_multichannel ? 1 : x->f_nchannels);
                     
                     for(ulong i = 0; i < x->f_instances.size(); i++)
                     {
-                        x->f_instances[i] = new (std::nothrow) ProcessInstance(x->f_global,
+                        t_canvas* parent = hoa_process_parent(x);
+                        x->f_instances[i] = parent ? new (std::nothrow) ProcessInstance(parent,
                                                                                atom_getsym(argv+1),
                                                                                hoa_sym_harmonics,
                                                                                hoa_sym_2d,
                                                                                long(order),
-                                                                               long(Harmonic<Hoa2d, t_sample>::getDegree(i)),
-                                                                               Harmonic<Hoa2d, t_sample>::getOrder(i),
-                                                                               narg, args, natr, atrs);
+                                                                               x->f_multichannel ? -1 : long(Harmonic<Hoa2d, t_sample>::getDegree(i)),
+                                                                               x->f_multichannel ? -1 : Harmonic<Hoa2d, t_sample>::getOrder(i),
+                                                                               narg, args, natr, atrs) : NULL;
                         if(!x->f_instances[i])
                         {
                             pd_error(x, "%s : Error while loading canvas.", s->s_name);
@@ -819,18 +1375,20 @@ static void *hoa_process_new(t_symbol *s, int argc, t_atom *argv)
                     x->f_domain    = hoa_sym_harmonics;
                     x->f_dimension = hoa_sym_3d;
                     ulong order  = pd_clip_minmax(atom_getlong(argv), 1, 10);
-                    x->f_instances.resize(Harmonic<Hoa3d, t_sample>::getNumberOfHarmonics(order));
+                    x->f_nchannels = Harmonic<Hoa3d, t_sample>::getNumberOfHarmonics(order);
+                    x->f_instances.resize(x->f_multichannel ? 1 : x->f_nchannels);
                     
                     for(ulong i = 0; i < x->f_instances.size(); i++)
                     {
-                        x->f_instances[i] = new (std::nothrow) ProcessInstance(x->f_global,
+                        t_canvas* parent = hoa_process_parent(x);
+                        x->f_instances[i] = parent ? new (std::nothrow) ProcessInstance(parent,
                                                                                atom_getsym(argv+1),
                                                                                hoa_sym_harmonics,
                                                                                hoa_sym_3d,
                                                                                long(order),
-                                                                               long(Harmonic<Hoa3d, t_sample>::getDegree(i)),
-                                                                               Harmonic<Hoa3d, t_sample>::getOrder(i),
-                                                                               narg, args, natr, atrs);
+                                                                               x->f_multichannel ? -1 : long(Harmonic<Hoa3d, t_sample>::getDegree(i)),
+                                                                               x->f_multichannel ? -1 : Harmonic<Hoa3d, t_sample>::getOrder(i),
+                                                                               narg, args, natr, atrs) : NULL;
                         if(!x->f_instances[i])
                         {
                             pd_error(x, "%s : Error while loading canvas.", s->s_name);
@@ -844,18 +1402,20 @@ static void *hoa_process_new(t_symbol *s, int argc, t_atom *argv)
                     x->f_domain    = hoa_sym_planewaves;
                     x->f_dimension = hoa_sym_2d;
                     ulong argument  = pd_clip_minmax(atom_getlong(argv), 1, HOA_MAX_PLANEWAVES);
-                    x->f_instances.resize(argument);
+                    x->f_nchannels = argument;
+                    x->f_instances.resize(x->f_multichannel ? 1 : x->f_nchannels);
                     
                     for(ulong i = 0; i < x->f_instances.size(); i++)
                     {
-                        x->f_instances[i] = new (std::nothrow) ProcessInstance(x->f_global,
+                        t_canvas* parent = hoa_process_parent(x);
+                        x->f_instances[i] = parent ? new (std::nothrow) ProcessInstance(parent,
                                                                                atom_getsym(argv+1),
                                                                                hoa_sym_planewaves,
                                                                                hoa_sym_2d,
                                                                                long(argument),
-                                                                               long(i+1),
-                                                                               long(i+1),
-                                                                               narg, args, natr, atrs);
+                                                                               x->f_multichannel ? -1 : long(i+1),
+                                                                               x->f_multichannel ? -1 : long(i+1),
+                                                                               narg, args, natr, atrs) : NULL;
                         if(!x->f_instances[i])
                         {
                             pd_error(x, "%s : Error while loading canvas.", s->s_name);
@@ -869,18 +1429,20 @@ static void *hoa_process_new(t_symbol *s, int argc, t_atom *argv)
                     x->f_domain    = hoa_sym_planewaves;
                     x->f_dimension = hoa_sym_3d;
                     ulong argument = pd_clip_minmax(atom_getlong(argv), 1, HOA_MAX_PLANEWAVES);
-                    x->f_instances.resize(argument);
+                    x->f_nchannels = argument;
+                    x->f_instances.resize(x->f_multichannel ? 1 : x->f_nchannels);
                     
                     for(ulong i = 0; i < x->f_instances.size(); i++)
                     {
-                        x->f_instances[i] = new (std::nothrow) ProcessInstance(x->f_global,
+                        t_canvas* parent = hoa_process_parent(x);
+                        x->f_instances[i] = parent ? new (std::nothrow) ProcessInstance(parent,
                                                                                atom_getsym(argv+1),
                                                                                hoa_sym_planewaves,
                                                                                hoa_sym_3d,
                                                                                long(argument),
-                                                                               long(i+1),
-                                                                               long(i+1),
-                                                                               narg, args, natr, atrs);
+                                                                               x->f_multichannel ? -1 : long(i+1),
+                                                                               x->f_multichannel ? -1 : long(i+1),
+                                                                               narg, args, natr, atrs) : NULL;
                         if(!x->f_instances[i])
                         {
                             pd_error(x, "%s : Error while loading canvas.", s->s_name);
@@ -919,16 +1481,16 @@ static void *hoa_process_new(t_symbol *s, int argc, t_atom *argv)
                 }
                 
                 eobj_dspsetup(x,
-                              long(have_sig_ins * x->f_instances.size() + max_sig_ins_extra),
-                              long(have_sig_outs * x->f_instances.size() + max_sig_outs_extra));
-                for(ulong i = 0; i < have_sig_outs * x->f_instances.size() + max_sig_outs_extra; i++)
+                              long(have_sig_ins * x->f_nchannels + max_sig_ins_extra),
+                              long(have_sig_outs * x->f_nchannels + max_sig_outs_extra));
+                for(ulong i = 0; i < have_sig_outs * x->f_nchannels + max_sig_outs_extra; i++)
                 {
                     x->f_outlets_signals.push_back(Signal<t_sample>::alloc(HOA_MAXBLKSIZE));
                 }
                 
                 if(have_ctl_ins && !have_sig_ins)
                 {
-                    for(ulong i = 0; i < x->f_instances.size(); i++)
+                    for(ulong i = 0; i < x->f_nchannels; i++)
                     {
                         eobj_proxynew(x);
                     }
@@ -937,6 +1499,9 @@ static void *hoa_process_new(t_symbol *s, int argc, t_atom *argv)
                 {
                     eobj_proxynew(x);
                 }
+                x->f_dispatched.assign(have_sig_ins * x->f_nchannels + max_sig_ins_extra
+                                       + (have_ctl_ins && !have_sig_ins) * x->f_nchannels
+                                       + (max_ctl_ins_extra > max_sig_ins_extra ? max_ctl_ins_extra - max_sig_ins_extra : 0ul), 0ul);
                 
                 if(have_ctl_outs)
                 {
@@ -961,6 +1526,22 @@ static void *hoa_process_new(t_symbol *s, int argc, t_atom *argv)
                     }
                 }
                 x->f_have_ins = have_ctl_ins || have_sig_ins;
+                
+                if(x->f_profiling)
+                {
+                    for(ulong i = 0; i < x->f_instances.size(); i++)
+                    {
+                        x->f_instances[i]->setSwitch(x->f_switches[i]);
+                    }
+                    x->f_info = outlet_new((t_object *)x, &s_anything);
+                }
+                
+                t_binbuf* d = binbuf_via_atoms(int(natr), atrs);
+                if(d)
+                {
+                    ebox_attrprocess_viabinbuf(x, d);
+                    binbuf_free(d);
+                }
             }
         }
         else
@@ -985,12 +1566,33 @@ extern "C" void setup_hoa0x2eprocess_tilde(void)
     eclass_addmethod(c, (method)hoa_process_click,      "click",    A_NULL, 0);
     eclass_addmethod(c, (method)hoa_process_open,       "open",     A_GIMME, 0);
     eclass_addmethod(c, (method)hoa_process_target,     "target",   A_GIMME, 0);
+    eclass_addmethod(c, (method)hoa_process_spread,     "spread",   A_GIMME, 0);
+    eclass_addmethod(c, (method)hoa_process_dispatched, "dispatched", A_GIMME, 0);
+    eclass_addmethod(c, (method)hoa_process_cputime,    "cputime",  A_GIMME, 0);
 
     eclass_addmethod(c, (method)hoa_process_bang,       "bang",     A_CANT,  0);
     eclass_addmethod(c, (method)hoa_process_float,      "float",    A_FLOAT, 0);
     eclass_addmethod(c, (method)hoa_process_symbol,     "symbol",   A_SYMBOL,0);
     eclass_addmethod(c, (method)hoa_process_list,       "list",     A_GIMME, 0);
     eclass_addmethod(c, (method)hoa_process_anything,   "anything", A_GIMME, 0);
+    
+    CLASS_ATTR_LONG             (c, "blocksize", 0, t_hoa_process, f_blocksize);
+    CLASS_ATTR_ACCESSORS        (c, "blocksize", NULL, hoa_process_blocksize_set);
+    CLASS_ATTR_CATEGORY         (c, "blocksize", 0, "Behavior");
+    CLASS_ATTR_LABEL            (c, "blocksize", 0, "Block Size of the Instances");
+    CLASS_ATTR_SAVE             (c, "blocksize", 0);
+    
+    CLASS_ATTR_LONG             (c, "overlap", 0, t_hoa_process, f_overlap);
+    CLASS_ATTR_ACCESSORS        (c, "overlap", NULL, hoa_process_overlap_set);
+    CLASS_ATTR_CATEGORY         (c, "overlap", 0, "Behavior");
+    CLASS_ATTR_LABEL            (c, "overlap", 0, "Overlap of the Instances");
+    CLASS_ATTR_SAVE             (c, "overlap", 0);
+    
+    CLASS_ATTR_LONG             (c, "upsample", 0, t_hoa_process, f_upsample);
+    CLASS_ATTR_ACCESSORS        (c, "upsample", NULL, hoa_process_upsample_set);
+    CLASS_ATTR_CATEGORY         (c, "upsample", 0, "Behavior");
+    CLASS_ATTR_LABEL            (c, "upsample", 0, "Upsampling of the Instances");
+    CLASS_ATTR_SAVE             (c, "upsample", 0);
 
     eclass_register(CLASS_OBJ, c);
     hoa_process_class = c;
@@ -8,14 +8,189 @@
 #include "../ThirdParty/HoaLibrary/Sources/Hoa.hpp"
 using namespace hoa;
 
+//! A points x harmonics matrix that evaluates the harmonics at the display points of a scope.
+/** The matrices are shared by all the scopes with the same dimension, order, grid and view rotation. They are computed once by probing the Scope with each harmonic, then every tick is rendered with a single matrix-vector product.
+ */
+typedef struct _hoa_scope_basis
+{
+    ulong           dimension;
+    ulong           order;
+    ulong           rows;
+    ulong           columns;
+    double          rotation[3];
+    ulong           count;
+    t_sample*       matrix;
+    t_sample*       abscissa;
+    t_sample*       ordinate;
+} t_hoa_scope_basis;
+
+static vector<t_hoa_scope_basis*> hoa_scope_bases;
+
+static t_hoa_scope_basis* hoa_scope_basis_find(const ulong dimension, const ulong order, const ulong rows, const ulong columns, const double* rotation)
+{
+    for(ulong i = 0; i < hoa_scope_bases.size(); i++)
+    {
+        t_hoa_scope_basis* b = hoa_scope_bases[i];
+        if(b->dimension == dimension && b->order == order && b->rows == rows && b->columns == columns &&
+           b->rotation[0] == rotation[0] && b->rotation[1] == rotation[1] && b->rotation[2] == rotation[2])
+        {
+            b->count++;
+            return b;
+        }
+    }
+    return NULL;
+}
+
+static t_hoa_scope_basis* hoa_scope_basis_new(const ulong dimension, const ulong order, const ulong rows, const ulong columns, const double* rotation, const ulong nharmonics)
+{
+    t_hoa_scope_basis* b = new t_hoa_scope_basis;
+    b->dimension    = dimension;
+    b->order        = order;
+    b->rows         = rows;
+    b->columns      = columns;
+    b->rotation[0]  = rotation[0];
+    b->rotation[1]  = rotation[1];
+    b->rotation[2]  = rotation[2];
+    b->count        = 1;
+    b->matrix       = Signal<t_sample>::alloc(rows * columns * nharmonics);
+    b->abscissa     = Signal<t_sample>::alloc(rows * columns);
+    b->ordinate     = Signal<t_sample>::alloc(rows * columns);
+    hoa_scope_bases.push_back(b);
+    return b;
+}
+
+static void hoa_scope_basis_release(t_hoa_scope_basis* b)
+{
+    if(b && !(--b->count))
+    {
+        for(ulong i = 0; i < hoa_scope_bases.size(); i++)
+        {
+            if(hoa_scope_bases[i] == b)
+            {
+                hoa_scope_bases.erase(hoa_scope_bases.begin() + long(i));
+                break;
+            }
+        }
+        Signal<t_sample>::free(b->matrix);
+        Signal<t_sample>::free(b->abscissa);
+        Signal<t_sample>::free(b->ordinate);
+        delete b;
+    }
+}
+
+//! The amplitude of the probes, small enough to never trigger the normalization of the Scope.
+static const t_sample hoa_scope_probe = 0.001;
+
+static t_hoa_scope_basis* hoa_scope_basis_get(Scope<Hoa2d, t_sample>* scope, const double* rotation)
+{
+    const ulong nharmo  = scope->getNumberOfHarmonics();
+    const ulong npoints = scope->getNumberOfPoints();
+    t_hoa_scope_basis* b = hoa_scope_basis_find(2, scope->getDecompositionOrder(), 1, npoints, rotation);
+    if(!b)
+    {
+        b = hoa_scope_basis_new(2, scope->getDecompositionOrder(), 1, npoints, rotation, nharmo);
+        t_sample* probe = Signal<t_sample>::alloc(nharmo);
+        for(ulong i = 0; i < nharmo; i++)
+        {
+            memset(probe, 0, nharmo * sizeof(t_sample));
+            probe[i] = hoa_scope_probe;
+            scope->process(probe);
+            for(ulong j = 0; j < npoints; j++)
+            {
+                b->matrix[j * nharmo + i] = scope->getPointValue(j) / hoa_scope_probe;
+                if(!i)
+                {
+                    const double a = scope->getPointAbscissa(j), o = scope->getPointOrdinate(j);
+                    const double d = sqrt(a * a + o * o);
+                    b->abscissa[j] = d > 0. ? t_sample(a / d) : t_sample(0.);
+                    b->ordinate[j] = d > 0. ? t_sample(o / d) : t_sample(0.);
+                }
+            }
+        }
+        Signal<t_sample>::free(probe);
+    }
+    return b;
+}
+
+static t_hoa_scope_basis* hoa_scope_basis_get(Scope<Hoa3d, t_sample>* scope, const double* rotation)
+{
+    const ulong nharmo  = scope->getNumberOfHarmonics();
+    const ulong nrows   = scope->getNumberOfRows();
+    const ulong ncols   = scope->getNumberOfColumns();
+    t_hoa_scope_basis* b = hoa_scope_basis_find(3, scope->getDecompositionOrder(), nrows, ncols, rotation);
+    if(!b)
+    {
+        b = hoa_scope_basis_new(3, scope->getDecompositionOrder(), nrows, ncols, rotation, nharmo);
+        t_sample* probe = Signal<t_sample>::alloc(nharmo);
+        for(ulong i = 0; i < nharmo; i++)
+        {
+            memset(probe, 0, nharmo * sizeof(t_sample));
+            probe[i] = hoa_scope_probe;
+            scope->process(probe);
+            for(ulong j = 0; j < nrows; j++)
+            {
+                for(ulong k = 0; k < ncols; k++)
+                {
+                    b->matrix[(j * ncols + k) * nharmo + i] = scope->getPointValue(j, k) / hoa_scope_probe;
+                }
+            }
+        }
+        Signal<t_sample>::free(probe);
+    }
+    return b;
+}
+
+//! Evaluates the display values of a frame of harmonics.
+/** The values are normalized like the Scope does when the maximum exceeds 1.
+ */
+static void hoa_scope_basis_render(t_hoa_scope_basis* b, const ulong nharmo, const t_sample* frame, t_sample* values)
+{
+    const ulong npoints = b->rows * b->columns;
+    t_sample max = 0;
+    for(ulong i = 0; i < npoints; i++)
+    {
+        const t_sample* row = b->matrix + i * nharmo;
+        t_sample s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        ulong j = 0;
+        for(; j < (nharmo & ~3ul); j += 4)
+        {
+            s0 += row[j] * frame[j];
+            s1 += row[j+1] * frame[j+1];
+            s2 += row[j+2] * frame[j+2];
+            s3 += row[j+3] * frame[j+3];
+        }
+        for(; j < nharmo; j++)
+        {
+            s0 += row[j] * frame[j];
+        }
+        values[i] = (s0 + s1) + (s2 + s3);
+        const t_sample a = values[i] < 0 ? -values[i] : values[i];
+        max = a > max ? a : max;
+    }
+    if(max > 1.)
+    {
+        Signal<t_sample>::scale(npoints, t_sample(1. / max), values);
+    }
+}
+
 typedef struct  _hoa_scope
 {
 	t_edspbox               f_box;
     Scope<Hoa2d, t_sample>* f_scope;
+    t_hoa_scope_basis*      f_basis;
+    t_sample*               f_values;
     t_sample*               f_signals;
-	t_clock*                f_clock;
+    t_atom*                 f_atoms;
+    HoaTripleBuffer*        f_snapshot;
+    long                    f_ramp;
+    double                  f_samplerate;
+    t_symbol*               f_window;
 	int                     f_startclock;
 	long                    f_interval;
+    long                    f_output;
+    int                     f_pending;
+    t_clock*                f_output_clock;
+    t_outlet*               f_out;
 	long                    f_order;
     double                  f_view;
     float                   f_gain;
@@ -35,8 +210,13 @@ typedef struct  _hoa_scope_3d
 {
     t_edspbox               f_box;
     Scope<Hoa3d, t_sample>* f_scope;
+    t_hoa_scope_basis*      f_basis;
+    t_sample*               f_values;
     t_sample*               f_signals;
-    t_clock*                f_clock;
+    HoaTripleBuffer*        f_snapshot;
+    long                    f_ramp;
+    double                  f_samplerate;
+    t_symbol*               f_window;
     int                     f_startclock;
     long                    f_interval;
     long                    f_order;
@@ -57,43 +237,231 @@ typedef struct  _hoa_scope_3d
 
 static t_eclass *hoa_scope_3d_class;
 
-static void hoa_scope_perform(t_hoa_scope *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
+//! Accumulates a block in the snapshot of the writer and publishes it once the interval is reached and the previous snapshot was read.
+/** The snapshots hold the harmonics, then the last sample of each harmonic, then the number of samples. In frame mode only the first block of the interval is kept, in rms and peak modes the blocks are reduced. While the reader hasn't taken the previous snapshot the reduction goes on in the same one, and it restarts after HOA_SNAPSHOT_MAXPERIODS intervals if the reader stops.
+ */
+static void hoa_scope_accumulate(HoaTripleBuffer* snapshot, t_symbol* window, t_sample **ins, long numins, long sampleframes, long& ramp, long period)
+{
+    t_sample* snap = snapshot->write();
+    if(window == hoa_sym_rms)
+    {
+        for(long i = 0; i < numins; i++)
+        {
+            snap[i]          = hoa_signal_sumsquares(sampleframes, ins[i], snap[i]);
+            snap[numins + i] = ins[i][sampleframes-1];
+        }
+    }
+    else if(window == hoa_sym_peak)
+    {
+        for(long i = 0; i < numins; i++)
+        {
+            snap[i]          = hoa_signal_peak(sampleframes, ins[i], snap[i]);
+            snap[numins + i] = ins[i][sampleframes-1];
+        }
+    }
+    else if(!ramp)
+    {
+        for(long i = 0; i < numins; i++)
+        {
+            snap[i] = ins[i][0];
+        }
+    }
+    ramp += sampleframes;
+    if(ramp >= period && !snapshot->pending())
+    {
+        snap[numins * 2] = t_sample(ramp);
+        snapshot->publish();
+        memset(snapshot->write(), 0, snapshot->getSize() * sizeof(t_sample));
+        ramp = 0;
+    }
+    else if(ramp >= period * HOA_SNAPSHOT_MAXPERIODS)
+    {
+        memset(snap, 0, snapshot->getSize() * sizeof(t_sample));
+        ramp = 0;
+    }
+}
+
+//! Builds the frame to display from a snapshot.
+/** In rms and peak modes the magnitude of each harmonic is the value over the interval and its sign is the sign of the last sample.
+ */
+static void hoa_scope_frame(t_symbol* window, const ulong size, const float gain, t_sample const* snap, t_sample* frame)
+{
+    if(window == hoa_sym_rms || window == hoa_sym_peak)
+    {
+        const t_sample ratio = snap[size * 2] > 0 ? t_sample(1. / double(snap[size * 2])) : t_sample(0.);
+        for(ulong i = 0; i < size; i++)
+        {
+            const t_sample value = (window == hoa_sym_rms) ? sqrt(snap[i] * ratio) : snap[i];
+            frame[i] = (snap[size + i] < 0) ? -value * gain : value * gain;
+        }
+    }
+    else
+    {
+        for(ulong i = 0; i < size; i++)
+        {
+            frame[i] = snap[i] * gain;
+        }
+    }
+}
+
+//! Coarsens the circle when the order is low, the number of points is still far above the number of lobes.
+static ulong hoa_scope_getnpoints(const ulong order)
+{
+    return ulong(pd_clip_minmax(long(order) * 24, 72, HOA_DISPLAY_NPOINTS));
+}
+
+static void hoa_scope_update(t_hoa_scope *x)
+{
+    const double rotation[3] = {0., 0., x->f_view / 360. * HOA_2PI};
+    x->f_scope->setViewRotation(rotation[0], rotation[1], rotation[2]);
+    x->f_scope->computeRendering();
+    hoa_scope_basis_release(x->f_basis);
+    x->f_basis = hoa_scope_basis_get(x->f_scope, rotation);
+    if(x->f_values)
+    {
+        Signal<t_sample>::free(x->f_values);
+    }
+    x->f_values = Signal<t_sample>::alloc(x->f_scope->getNumberOfPoints());
+    memset(x->f_values, 0, x->f_scope->getNumberOfPoints() * sizeof(t_sample));
+}
+
+//! Takes the number of rows allowed by the size of the box and coarsens the sphere when the order is low.
+static ulong hoa_scope_3d_getnrows(t_hoa_scope_3d *x, const ulong order)
 {
-    for(long i = 0; i < numins; i++)
+    ulong nrow;
+    t_rect rect;
+    ebox_get_rect_for_view((t_ebox *)x, &rect);
+    if(rect.width >= 200)
     {
-        Signal<t_sample>::copy(ulong(sampleframes), ins[i], 1, x->f_signals+i, ulong(numins));
+        nrow = _hoa_scope_3d::f_row1;
     }
-    Signal<t_sample>::scale(ulong(numins * sampleframes), x->f_gain, x->f_signals);
+    else if(rect.width >= 100)
+    {
+        nrow = _hoa_scope_3d::f_row2;
+    }
+    else
+    {
+        nrow = _hoa_scope_3d::f_row3;
+    }
+    return min(nrow, max(ulong(_hoa_scope_3d::f_row3), (order + 1) * 4));
+}
+
+static void hoa_scope_3d_update(t_hoa_scope_3d *x)
+{
+    const double rotation[3] = {x->f_view[0] / 360. * HOA_2PI, x->f_view[1] / 360. * HOA_2PI, x->f_view[2] / 360. * HOA_2PI};
+    x->f_scope->setViewRotation(rotation[0], rotation[1], rotation[2]);
+    x->f_scope->computeRendering();
+    hoa_scope_basis_release(x->f_basis);
+    x->f_basis = hoa_scope_basis_get(x->f_scope, rotation);
+    if(x->f_values)
+    {
+        Signal<t_sample>::free(x->f_values);
+    }
+    x->f_values = Signal<t_sample>::alloc(x->f_scope->getNumberOfRows() * x->f_scope->getNumberOfColumns());
+    memset(x->f_values, 0, x->f_scope->getNumberOfRows() * x->f_scope->getNumberOfColumns() * sizeof(t_sample));
+}
+
+//! Returns the interval of the snapshots, the data output is the only consumer when it's on so it sets the pace and the GUI displays its windows.
+static long hoa_scope_getperiod(t_hoa_scope *x)
+{
+    if(x->f_output)
+    {
+        return x->f_output;
+    }
+    return x->f_interval;
+}
+
+static void hoa_scope_perform(t_hoa_scope *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    hoa_scope_accumulate(x->f_snapshot, x->f_window, ins, numins, sampleframes, x->f_ramp, long(x->f_samplerate * double(hoa_scope_getperiod(x)) * 0.001));
     if(x->f_startclock)
 	{
 		x->f_startclock = 0;
-		clock_delay(x->f_clock, 0);
+		hoa_frame_start();
 	}
 }
 
+//! Outputs the harmonics without the gain, then applies the gain to the frame that the GUI will display.
+static void hoa_scope_output(t_hoa_scope *x)
+{
+    if(!x->f_output)
+    {
+        return;
+    }
+    bool fresh;
+    t_sample const* snap = x->f_snapshot->read(fresh);
+    if(fresh)
+    {
+        const ulong nharmo = ulong(x->f_scope->getNumberOfHarmonics());
+        hoa_scope_frame(x->f_window, nharmo, 1.f, snap, x->f_signals);
+
+        for(ulong i = 0; i < nharmo; i++)
+        {
+            atom_setfloat(x->f_atoms+i, x->f_signals[i]);
+        }
+        outlet_anything(x->f_out, hoa_sym_harmonics, int(nharmo), x->f_atoms);
+
+        Signal<t_sample>::scale(nharmo, t_sample(x->f_gain), x->f_signals);
+        x->f_pending = 1;
+    }
+
+    if(canvas_dspstate)
+    {
+        clock_delay(x->f_output_clock, x->f_output);
+    }
+}
+
 static void hoa_scope_tick(t_hoa_scope *x)
 {
-    x->f_scope->process(x->f_signals);
+    if(x->f_output)
+    {
+        if(!x->f_pending)
+        {
+            return;
+        }
+        x->f_pending = 0;
+    }
+    else
+    {
+        bool fresh;
+        t_sample const* snap = x->f_snapshot->read(fresh);
+        if(!fresh)
+        {
+            return;
+        }
+        hoa_scope_frame(x->f_window, ulong(x->f_scope->getNumberOfHarmonics()), x->f_gain, snap, x->f_signals);
+    }
+    hoa_scope_basis_render(x->f_basis, ulong(x->f_scope->getNumberOfHarmonics()), x->f_signals, x->f_values);
 
 	ebox_invalidate_layer((t_ebox *)x, hoa_sym_harmonics_layer);
-	ebox_redraw((t_ebox *)x);
-	if(canvas_dspstate)
-		clock_delay(x->f_clock, x->f_interval);
+	hoa_frame_redraw((t_ebox *)x);
 }
 
 static void hoa_scope_dsp(t_hoa_scope *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
 {
+    memset(x->f_snapshot->write(), 0, x->f_snapshot->getSize() * sizeof(t_sample));
+    x->f_samplerate = samplerate;
+    x->f_ramp       = 0;
     object_method(dsp64, gensym("dsp_add"), x, (method)hoa_scope_perform, 0, NULL);
     x->f_startclock = 1;
+    if(x->f_output)
+    {
+        clock_delay(x->f_output_clock, x->f_output);
+    }
 }
 
 static void hoa_scope_free(t_hoa_scope *x)
 {
+    hoa_frame_unregister((t_ebox *)x);
+    clock_free(x->f_output_clock);
 	ebox_free((t_ebox *)x);
-    clock_free(x->f_clock);
 
     delete x->f_scope;
+    hoa_scope_basis_release(x->f_basis);
+    Signal<t_sample>::free(x->f_values);
     Signal<t_sample>::free(x->f_signals);
+    delete [] x->f_atoms;
+    delete x->f_snapshot;
 }
 
 static t_pd_err hoa_scope_notify(t_hoa_scope *x, t_symbol *s, t_symbol *msg, void *sender, void *data)
@@ -104,7 +472,7 @@ static t_pd_err hoa_scope_notify(t_hoa_scope *x, t_symbol *s, t_symbol *msg, voi
         {
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_harmonics_layer);
         }
-		ebox_redraw((t_ebox *)x);
+		hoa_frame_redraw((t_ebox *)x);
 	}
 	return 0;
 }
@@ -136,9 +504,16 @@ static t_pd_err hoa_scope_set_order(t_hoa_scope *x, t_object *attr, int ac, t_at
 
             delete x->f_scope;
             Signal<t_sample>::free(x->f_signals);
-            x->f_scope      = new Scope<Hoa2d, t_sample>(order, HOA_DISPLAY_NPOINTS);
+            delete [] x->f_atoms;
+            delete x->f_snapshot;
+            x->f_scope      = new Scope<Hoa2d, t_sample>(order, hoa_scope_getnpoints(order));
             x->f_order      = long(x->f_scope->getDecompositionOrder());
-            x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics() * HOA_MAXBLKSIZE);
+            x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics());
+            x->f_atoms      = new t_atom[x->f_scope->getNumberOfHarmonics()];
+            x->f_snapshot   = new HoaTripleBuffer(x->f_scope->getNumberOfHarmonics() * 2 + 1);
+            x->f_ramp       = 0;
+            x->f_pending    = 0;
+            hoa_scope_update(x);
 
             eobj_resize_inputs((t_ebox *)x, long(x->f_scope->getNumberOfHarmonics()));
             canvas_update_dsp();
@@ -149,14 +524,49 @@ static t_pd_err hoa_scope_set_order(t_hoa_scope *x, t_object *attr, int ac, t_at
 	return 0;
 }
 
+static t_pd_err hoa_scope_set_window(t_hoa_scope *x, t_object *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_SYM)
+    {
+        t_symbol* window = atom_getsym(argv);
+        if(window == hoa_sym_frame || window == hoa_sym_rms || window == hoa_sym_peak)
+        {
+            int dspState = canvas_suspend_dsp();
+            x->f_window = window;
+            memset(x->f_snapshot->write(), 0, x->f_snapshot->getSize() * sizeof(t_sample));
+            x->f_ramp    = 0;
+            canvas_resume_dsp(dspState);
+        }
+    }
+    return 0;
+}
+
+static t_pd_err hoa_scope_set_output(t_hoa_scope *x, t_object *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_LONG)
+    {
+        const long output = atom_getlong(argv);
+        x->f_output  = output > 0 ? max(output, (long)HOA_FRAME_INTERVAL) : 0;
+        x->f_pending = 0;
+        if(x->f_output && canvas_dspstate)
+        {
+            clock_delay(x->f_output_clock, x->f_output);
+        }
+        else
+        {
+            clock_unset(x->f_output_clock);
+        }
+    }
+    return 0;
+}
+
 static t_pd_err hoa_scope_set_view(t_hoa_scope *x, t_object *attr, int argc, t_atom *argv)
 {
     if (argc && argv && atom_gettype(argv) == A_LONG)
     {
         int dspState = canvas_suspend_dsp();
         x->f_view = atom_getfloat(argv);
-        x->f_scope->setViewRotation(0., 0., x->f_view / 360. * HOA_2PI);
-        x->f_scope->computeRendering();
+        hoa_scope_update(x);
         canvas_resume_dsp(dspState);
     }
 
@@ -231,16 +641,16 @@ static void draw_harmonics(t_hoa_scope *x, t_object *view, t_rect *rect)
         egraphics_set_color_rgba(g, &x->f_color_ph);
         for(ulong i = 0; i < x->f_scope->getNumberOfPoints(); i++)
         {
-            if(x->f_scope->getPointValue(i) >= 0)
+            if(x->f_values[i] >= 0)
             {
                 if(!pathLength)
                 {
-                    egraphics_move_to(g, x->f_scope->getPointAbscissa(i) * x->f_radius, x->f_scope->getPointOrdinate(i) * x->f_radius);
+                    egraphics_move_to(g, fabs(x->f_values[i]) * x->f_basis->abscissa[i] * x->f_radius, fabs(x->f_values[i]) * x->f_basis->ordinate[i] * x->f_radius);
                     pathLength++;
                 }
                 else
                 {
-                    egraphics_line_to(g, x->f_scope->getPointAbscissa(i) * x->f_radius, x->f_scope->getPointOrdinate(i) * x->f_radius);
+                    egraphics_line_to(g, fabs(x->f_values[i]) * x->f_basis->abscissa[i] * x->f_radius, fabs(x->f_values[i]) * x->f_basis->ordinate[i] * x->f_radius);
                 }
             }
         }
@@ -253,16 +663,16 @@ static void draw_harmonics(t_hoa_scope *x, t_object *view, t_rect *rect)
         egraphics_set_color_rgba(g, &x->f_color_nh);
         for(ulong i = 0; i < x->f_scope->getNumberOfPoints(); i++)
         {
-            if(x->f_scope->getPointValue(i) < 0)
+            if(x->f_values[i] < 0)
             {
                 if(!pathLength)
                 {
-                    egraphics_move_to(g, x->f_scope->getPointAbscissa(i) * x->f_radius, x->f_scope->getPointOrdinate(i) * x->f_radius);
+                    egraphics_move_to(g, fabs(x->f_values[i]) * x->f_basis->abscissa[i] * x->f_radius, fabs(x->f_values[i]) * x->f_basis->ordinate[i] * x->f_radius);
                     pathLength++;
                 }
                 else
                 {
-                    egraphics_line_to(g, x->f_scope->getPointAbscissa(i) * x->f_radius, x->f_scope->getPointOrdinate(i) * x->f_radius);
+                    egraphics_line_to(g, fabs(x->f_values[i]) * x->f_basis->abscissa[i] * x->f_radius, fabs(x->f_values[i]) * x->f_basis->ordinate[i] * x->f_radius);
                 }
             }
         }
@@ -294,14 +704,26 @@ static void *hoa_scope_new(t_symbol *s, int argc, t_atom *argv)
     {
         x->f_order      = 1;
         x->f_startclock = 0;
-        x->f_scope      = new Scope<Hoa2d, t_sample>(ulong(x->f_order), HOA_DISPLAY_NPOINTS);
+        x->f_scope      = new Scope<Hoa2d, t_sample>(ulong(x->f_order), hoa_scope_getnpoints(ulong(x->f_order)));
         x->f_order      = long(x->f_scope->getDecompositionOrder());
-        x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics() * HOA_MAXBLKSIZE);
+        x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics());
+        x->f_atoms      = new t_atom[x->f_scope->getNumberOfHarmonics()];
+        x->f_snapshot   = new HoaTripleBuffer(x->f_scope->getNumberOfHarmonics() * 2 + 1);
+        x->f_samplerate = sys_getsr();
+        x->f_basis      = NULL;
+        x->f_values     = NULL;
+        hoa_scope_update(x);
+        x->f_window     = hoa_sym_frame;
+        x->f_ramp       = 0;
+        x->f_output     = 0;
+        x->f_pending    = 0;
+        x->f_output_clock = clock_new(x, (t_method)hoa_scope_output);
 
         eobj_dspsetup(x, long(x->f_scope->getNumberOfHarmonics()), 0);
+        x->f_out        = listout(x);
         ebox_new((t_ebox *)x, 0 | EBOX_IGNORELOCKCLICK | EBOX_GROWLINK);
 
-        x->f_clock = clock_new(x,(t_method)hoa_scope_tick);
+        hoa_frame_register((t_ebox *)x, (t_method)hoa_scope_tick, &x->f_interval);
         x->f_startclock = 0;
 
         ebox_attrprocess_viabinbuf(x, d);
@@ -369,6 +791,24 @@ extern "C" void setup_hoa0x2e2d0x2escope_tilde(void)
     CLASS_ATTR_DEFAULT              (c, "interval", 0, "100");
     CLASS_ATTR_SAVE                 (c, "interval", 1);
 
+    CLASS_ATTR_SYMBOL               (c, "window", 0, t_hoa_scope, f_window);
+    CLASS_ATTR_ACCESSORS            (c, "window", NULL, hoa_scope_set_window);
+    CLASS_ATTR_CATEGORY             (c, "window", 0, "Behavior");
+    CLASS_ATTR_ORDER                (c, "window", 0, "3");
+    CLASS_ATTR_LABEL                (c, "window", 0, "Analysis Window");
+    CLASS_ATTR_DEFAULT              (c, "window", 0, "frame");
+    CLASS_ATTR_SAVE                 (c, "window", 1);
+    CLASS_ATTR_STYLE                (c, "window", 1, "menu");
+    CLASS_ATTR_ITEMS                (c, "window", 1, "frame rms peak");
+
+    CLASS_ATTR_LONG                 (c, "output", 0, t_hoa_scope, f_output);
+    CLASS_ATTR_ACCESSORS            (c, "output", NULL, hoa_scope_set_output);
+    CLASS_ATTR_CATEGORY             (c, "output", 0, "Behavior");
+    CLASS_ATTR_ORDER                (c, "output", 0, "4");
+    CLASS_ATTR_LABEL                (c, "output", 0, "Data Output Interval in Milliseconds (0 = off)");
+    CLASS_ATTR_DEFAULT              (c, "output", 0, "0");
+    CLASS_ATTR_SAVE                 (c, "output", 1);
+
     CLASS_ATTR_RGBA                 (c, "bgcolor", 0, t_hoa_scope, f_color_bg);
     CLASS_ATTR_CATEGORY             (c, "bgcolor", 0, "Color");
     CLASS_ATTR_STYLE                (c, "bgcolor", 0, "rgba");
@@ -404,32 +844,36 @@ extern "C" void setup_hoa0x2e2d0x2escope_tilde(void)
 
 static void hoa_scope_3d_perform(t_hoa_scope_3d *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
-    for(long i = 0; i < numins; i++)
-    {
-        Signal<t_sample>::copy(ulong(sampleframes), ins[i], 1, x->f_signals+i, ulong(numins));
-    }
-    Signal<t_sample>::scale(ulong(numins * sampleframes), x->f_gain, x->f_signals);
+    hoa_scope_accumulate(x->f_snapshot, x->f_window, ins, numins, sampleframes, x->f_ramp, long(x->f_samplerate * double(x->f_interval) * 0.001));
     if(x->f_startclock)
     {
         x->f_startclock = 0;
-        clock_delay(x->f_clock, 0);
+        hoa_frame_start();
     }
 }
 
 static void hoa_scope_3d_dsp(t_hoa_scope_3d *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
 {
+    memset(x->f_snapshot->write(), 0, x->f_snapshot->getSize() * sizeof(t_sample));
+    x->f_samplerate = samplerate;
+    x->f_ramp       = 0;
     object_method(dsp64, gensym("dsp_add"), x, (method)hoa_scope_3d_perform, 0, NULL);
     x->f_startclock = 1;
 }
 
 static void hoa_scope_3d_tick(t_hoa_scope_3d *x)
 {
-    x->f_scope->process(x->f_signals);
+    bool fresh;
+    t_sample const* snap = x->f_snapshot->read(fresh);
+    if(!fresh)
+    {
+        return;
+    }
+    hoa_scope_frame(x->f_window, ulong(x->f_scope->getNumberOfHarmonics()), x->f_gain, snap, x->f_signals);
+    hoa_scope_basis_render(x->f_basis, ulong(x->f_scope->getNumberOfHarmonics()), x->f_signals, x->f_values);
 
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_harmonics_layer);
-    ebox_redraw((t_ebox *)x);
-    if(canvas_dspstate)
-        clock_delay(x->f_clock, x->f_interval);
+    hoa_frame_redraw((t_ebox *)x);
 }
 
 static t_pd_err hoa_scope_3d_notify(t_hoa_scope_3d *x, t_symbol *s, t_symbol *msg, void *sender, void *data)
@@ -442,33 +886,20 @@ static t_pd_err hoa_scope_3d_notify(t_hoa_scope_3d *x, t_symbol *s, t_symbol *ms
         }
         else if(s == hoa_sym_size)
         {
-            ulong nrow;
-            t_rect rect;
-            ebox_get_rect_for_view((t_ebox *)x, &rect);
-            if(rect.width >= 200)
-            {
-                nrow = _hoa_scope_3d::f_row1;
-            }
-            else if(rect.width >= 100)
-            {
-                nrow = _hoa_scope_3d::f_row2;
-            }
-            else
-            {
-                nrow = _hoa_scope_3d::f_row3;
-            }
+            const ulong nrow = hoa_scope_3d_getnrows(x, ulong(x->f_order));
             if(x->f_scope->getNumberOfRows() != nrow)
             {
                 int dspState = canvas_suspend_dsp();
                 delete x->f_scope;
                 x->f_scope      =  new Scope<Hoa3d, t_sample>(ulong(x->f_order), nrow, nrow * 2);
+                hoa_scope_3d_update(x);
 
                 eobj_resize_inputs((t_ebox *)x, long(x->f_scope->getNumberOfHarmonics()));
                 canvas_update_dsp();
                 canvas_resume_dsp(dspState);
             }
         }
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
     return 0;
 }
@@ -498,27 +929,16 @@ static t_pd_err hoa_scope_3d_set_order(t_hoa_scope_3d *x, t_object *attr, int ac
         {
             int dspState = canvas_suspend_dsp();
 
-            ulong nrow;
-            t_rect rect;
-            ebox_get_rect_for_view((t_ebox *)x, &rect);
-            if(rect.width >= 200)
-            {
-                nrow = _hoa_scope_3d::f_row1;
-            }
-            else if(rect.width >= 100)
-            {
-                nrow = _hoa_scope_3d::f_row2;
-            }
-            else
-            {
-                nrow = _hoa_scope_3d::f_row3;
-            }
-            
+            const ulong nrow = hoa_scope_3d_getnrows(x, order);
             delete x->f_scope;
             Signal<t_sample>::free(x->f_signals);
+            delete x->f_snapshot;
             x->f_scope      =  new Scope<Hoa3d, t_sample>(order, nrow, nrow * 2);
             x->f_order      = long(x->f_scope->getDecompositionOrder());
-            x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics() * HOA_MAXBLKSIZE);
+            x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics());
+            x->f_snapshot   = new HoaTripleBuffer(x->f_scope->getNumberOfHarmonics() * 2 + 1);
+            x->f_ramp       = 0;
+            hoa_scope_3d_update(x);
 
             eobj_resize_inputs((t_ebox *)x, long(x->f_scope->getNumberOfHarmonics()));
             canvas_update_dsp();
@@ -529,6 +949,23 @@ static t_pd_err hoa_scope_3d_set_order(t_hoa_scope_3d *x, t_object *attr, int ac
     return 0;
 }
 
+static t_pd_err hoa_scope_3d_set_window(t_hoa_scope_3d *x, t_object *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_SYM)
+    {
+        t_symbol* window = atom_getsym(argv);
+        if(window == hoa_sym_frame || window == hoa_sym_rms || window == hoa_sym_peak)
+        {
+            int dspState = canvas_suspend_dsp();
+            x->f_window = window;
+            memset(x->f_snapshot->write(), 0, x->f_snapshot->getSize() * sizeof(t_sample));
+            x->f_ramp    = 0;
+            canvas_resume_dsp(dspState);
+        }
+    }
+    return 0;
+}
+
 static t_pd_err hoa_scope_3d_set_view(t_hoa_scope_3d *x, t_object *attr, int argc, t_atom *argv)
 {
     if (argc && argv && atom_gettype(argv) == A_LONG)
@@ -546,8 +983,7 @@ static t_pd_err hoa_scope_3d_set_view(t_hoa_scope_3d *x, t_object *attr, int arg
             x->f_view[2] = atom_getfloat(argv+2);
         else
             x->f_view[2] = x->f_scope->getViewRotationZ() * 360. / HOA_2PI;
-        x->f_scope->setViewRotation(x->f_view[0] / 360. * HOA_2PI, x->f_view[1] / 360. * HOA_2PI, x->f_view[2] / 360. * HOA_2PI);
-        x->f_scope->computeRendering();
+        hoa_scope_3d_update(x);
         canvas_resume_dsp(dspState);
     }
 
@@ -583,7 +1019,7 @@ static void draw_harmonics(t_hoa_scope_3d *x, t_object *view, t_rect *rect)
             for(ulong i = 0; i < x->f_scope->getNumberOfColumns(); i++)
             {
                 double azim = x->f_scope->getPointAzimuth(i);
-                double value = x->f_scope->getPointValue(j, i);
+                double value = x->f_values[j * x->f_basis->columns + i];
                 if(value >= 0)
                 {
                     value *= x->f_radius;
@@ -608,7 +1044,7 @@ static void draw_harmonics(t_hoa_scope_3d *x, t_object *view, t_rect *rect)
             for(ulong i = 0; i < x->f_scope->getNumberOfColumns(); i++)
             {
                 double azim = x->f_scope->getPointAzimuth(i);
-                double value = x->f_scope->getPointValue(j, i);
+                double value = x->f_values[j * x->f_basis->columns + i];
                 if(value < 0)
                 {
                     value *= -x->f_radius;
@@ -672,7 +1108,7 @@ static void draw_harmonics(t_hoa_scope_3d *x, t_object *view, t_rect *rect)
             for(ulong i = 0; i < x->f_scope->getNumberOfColumns(); i++)
             {
                 double azim = x->f_scope->getPointAzimuth(i);
-                double value = x->f_scope->getPointValue(j, i);
+                double value = x->f_values[j * x->f_basis->columns + i];
                 if(value >= 0)
                 {
                     value *= x->f_radius;
@@ -697,7 +1133,7 @@ static void draw_harmonics(t_hoa_scope_3d *x, t_object *view, t_rect *rect)
             for(ulong i = 0; i < x->f_scope->getNumberOfColumns(); i++)
             {
                 double azim = x->f_scope->getPointAzimuth(i);
-                double value = x->f_scope->getPointValue(j, i);
+                double value = x->f_values[j * x->f_basis->columns + i];
                 if(value < 0)
                 {
                     value *= -x->f_radius;
@@ -743,14 +1179,21 @@ static void *hoa_scope_3d_new(t_symbol *s, int argc, t_atom *argv)
     {
         x->f_order      = 1;
         x->f_startclock = 0;
-        x->f_scope      = new Scope<Hoa3d, t_sample>(ulong(x->f_order), _hoa_scope_3d::f_row1, _hoa_scope_3d::f_row1 * 2);
+        x->f_scope      = new Scope<Hoa3d, t_sample>(ulong(x->f_order), _hoa_scope_3d::f_row3, _hoa_scope_3d::f_row3 * 2);
         x->f_order      = long(x->f_scope->getDecompositionOrder());
-        x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics() * HOA_MAXBLKSIZE);
+        x->f_signals    = Signal<t_sample>::alloc(x->f_scope->getNumberOfHarmonics());
+        x->f_snapshot   = new HoaTripleBuffer(x->f_scope->getNumberOfHarmonics() * 2 + 1);
+        x->f_samplerate = sys_getsr();
+        x->f_basis      = NULL;
+        x->f_values     = NULL;
+        hoa_scope_3d_update(x);
+        x->f_window     = hoa_sym_frame;
+        x->f_ramp       = 0;
 
         eobj_dspsetup(x, long(x->f_scope->getNumberOfHarmonics()), 0);
         ebox_new((t_ebox *)x, 0 | EBOX_IGNORELOCKCLICK | EBOX_GROWLINK);
 
-        x->f_clock = clock_new(x,(t_method)hoa_scope_3d_tick);
+        hoa_frame_register((t_ebox *)x, (t_method)hoa_scope_3d_tick, &x->f_interval);
         x->f_startclock = 0;
 
         ebox_attrprocess_viabinbuf(x, d);
@@ -764,7 +1207,7 @@ static void *hoa_scope_3d_new(t_symbol *s, int argc, t_atom *argv)
 
 static void hoa_scope_3d_free(t_hoa_scope_3d *x)
 {
-    clock_free(x->f_clock);
+    hoa_frame_unregister((t_ebox *)x);
     ebox_free((t_ebox *)x);
     if(x->f_scope)
     {
@@ -774,6 +1217,15 @@ static void hoa_scope_3d_free(t_hoa_scope_3d *x)
     {
         Signal<t_sample>::free(x->f_signals);
     }
+    if(x->f_snapshot)
+    {
+        delete x->f_snapshot;
+    }
+    if(x->f_values)
+    {
+        Signal<t_sample>::free(x->f_values);
+    }
+    hoa_scope_basis_release(x->f_basis);
 }
 
 extern "C" void setup_hoa0x2e3d0x2escope_tilde(void)
@@ -831,6 +1283,16 @@ extern "C" void setup_hoa0x2e3d0x2escope_tilde(void)
     CLASS_ATTR_DEFAULT              (c, "interval", 0, "100");
     CLASS_ATTR_SAVE                 (c, "interval", 1);
 
+    CLASS_ATTR_SYMBOL               (c, "window", 0, t_hoa_scope_3d, f_window);
+    CLASS_ATTR_ACCESSORS            (c, "window", NULL, hoa_scope_3d_set_window);
+    CLASS_ATTR_CATEGORY             (c, "window", 0, "Behavior");
+    CLASS_ATTR_ORDER                (c, "window", 0, "3");
+    CLASS_ATTR_LABEL                (c, "window", 0, "Analysis Window");
+    CLASS_ATTR_DEFAULT              (c, "window", 0, "frame");
+    CLASS_ATTR_SAVE                 (c, "window", 1);
+    CLASS_ATTR_STYLE                (c, "window", 1, "menu");
+    CLASS_ATTR_ITEMS                (c, "window", 1, "frame rms peak");
+
     CLASS_ATTR_RGBA                 (c, "bgcolor", 0, t_hoa_scope_3d, f_color_bg);
     CLASS_ATTR_CATEGORY             (c, "bgcolor", 0, "Color");
     CLASS_ATTR_STYLE                (c, "bgcolor", 0, "rgba");
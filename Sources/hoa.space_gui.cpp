@@ -171,12 +171,13 @@ void hoa_space_list(t_hoa_space *x, t_symbol *s, int ac, t_atom *av)
         hoa_space_output(x);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_space_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_points_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
 }
 
 void hoa_space_free(t_hoa_space *x)
 {
+    hoa_frame_unregister((t_ebox *)x);
     ebox_free((t_ebox *)x);
     delete [] x->f_channel_values;
     delete [] x->f_channel_refs;
@@ -471,7 +472,7 @@ void hoa_space_mouse_drag(t_hoa_space *x, t_object *patcherview, t_pt pt, long m
     
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_space_layer);
     ebox_invalidate_layer((t_ebox *)x, hoa_sym_points_layer);
-    ebox_redraw((t_ebox *)x);
+    hoa_frame_redraw((t_ebox *)x);
     hoa_space_output(x);
 }
 
@@ -501,7 +502,7 @@ t_pd_err channels_set(t_hoa_space *x, t_object *attr, int argc, t_atom *argv)
             ebox_invalidate_layer((t_ebox*)x, hoa_sym_background_layer);
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_space_layer);
             ebox_invalidate_layer((t_ebox *)x, hoa_sym_points_layer);
-            ebox_redraw((t_ebox *)x);
+            hoa_frame_redraw((t_ebox *)x);
         }
     }
 	return 0;
@@ -536,7 +537,7 @@ t_pd_err minmax_set(t_hoa_space *x, t_object *attr, int argc, t_atom *argv)
         
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_space_layer);
         ebox_invalidate_layer((t_ebox *)x, hoa_sym_points_layer);
-        ebox_redraw((t_ebox *)x);
+        hoa_frame_redraw((t_ebox *)x);
     }
 	return 0;
 }
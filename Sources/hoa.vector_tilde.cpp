@@ -0,0 +1,619 @@
+/*
+ // Copyright (c) 2012-2015 Eliott Paris, Julien Colafrancesco & Pierre Guillot, CICM, Universite Paris 8.
+ // For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ // WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ */
+
+#include "../hoa.library.hpp"
+#include "../ThirdParty/HoaLibrary/Sources/Hoa.hpp"
+using namespace hoa;
+
+//! The planar vectors of the scratch, each one holds a block.
+/** The pressure is the sum of the channels, the velocity the sum of the channels weighted by their axes, the energy the sum of the squared channels and the intensity the sum of the squared channels weighted by their axes.
+ */
+#define HOA_VECTOR_PRESSURE     0
+#define HOA_VECTOR_VELOCITY     1
+#define HOA_VECTOR_ENERGY       4
+#define HOA_VECTOR_INTENSITY    5
+#define HOA_VECTOR_SIZE         8
+
+typedef struct _hoa_vector
+{
+    t_edspobj                   f_obj;
+    Vector<Hoa2d, t_sample>*    f_vector;
+    t_sample*                   f_axes;
+    t_sample*                   f_scratch;
+    t_symbol*                   f_rate;
+    void*                       f_attrs;
+} t_hoa_vector;
+
+static t_eclass *hoa_vector_class;
+
+typedef struct _hoa_vector_3d
+{
+    t_edspobj                   f_obj;
+    Vector<Hoa3d, t_sample>*    f_vector;
+    t_sample*                   f_axes;
+    t_sample*                   f_scratch;
+    t_symbol*                   f_rate;
+    void*                       f_attrs;
+} t_hoa_vector_3d;
+
+static t_eclass *hoa_vector_3d_class;
+
+//! Sums the channels of a block in the planar vectors of the scratch, the loops run over the samples so they vectorize.
+static void hoa_vector_accumulate(t_sample const* axes, const ulong ncoords, t_sample **ins, const long numins, const long sampleframes, t_sample* scratch)
+{
+    t_sample* p = scratch + HOA_VECTOR_PRESSURE * sampleframes;
+    t_sample* e = scratch + HOA_VECTOR_ENERGY * sampleframes;
+    memset(scratch, 0, size_t(HOA_VECTOR_SIZE * sampleframes) * sizeof(t_sample));
+    for(long i = 0; i < numins; i++)
+    {
+        const t_sample* in = ins[i];
+        for(long j = 0; j < sampleframes; j++)
+        {
+            p[j] += in[j];
+            e[j] += in[j] * in[j];
+        }
+        for(ulong k = 0; k < ncoords; k++)
+        {
+            const t_sample a = axes[k * HOA_MAX_PLANEWAVES + ulong(i)];
+            t_sample* v = scratch + (HOA_VECTOR_VELOCITY + k) * sampleframes;
+            t_sample* n = scratch + (HOA_VECTOR_INTENSITY + k) * sampleframes;
+            for(long j = 0; j < sampleframes; j++)
+            {
+                v[j] += in[j] * a;
+                n[j] += in[j] * in[j] * a;
+            }
+        }
+    }
+}
+
+//! Outputs the vectors of each sample, the velocity coordinates then the energy coordinates.
+static void hoa_vector_sample(t_sample const* scratch, const ulong ncoords, const long sampleframes, t_sample **outs)
+{
+    const t_sample* p = scratch + HOA_VECTOR_PRESSURE * sampleframes;
+    const t_sample* e = scratch + HOA_VECTOR_ENERGY * sampleframes;
+    for(ulong k = 0; k < ncoords; k++)
+    {
+        const t_sample* v = scratch + (HOA_VECTOR_VELOCITY + k) * sampleframes;
+        const t_sample* n = scratch + (HOA_VECTOR_INTENSITY + k) * sampleframes;
+        t_sample* velocity  = outs[k];
+        t_sample* energy    = outs[ncoords + k];
+        for(long j = 0; j < sampleframes; j++)
+        {
+            velocity[j] = p[j] != 0 ? v[j] / p[j] : t_sample(0.);
+            energy[j]   = e[j] > 0 ? n[j] / e[j] : t_sample(0.);
+        }
+    }
+}
+
+//! Outputs the vectors averaged over the block, the velocity is the ratio of the pressure-velocity products to the squared pressure.
+static void hoa_vector_block(t_sample const* scratch, const ulong ncoords, const long sampleframes, t_sample **outs)
+{
+    const t_sample* p = scratch + HOA_VECTOR_PRESSURE * sampleframes;
+    const t_sample* e = scratch + HOA_VECTOR_ENERGY * sampleframes;
+    t_sample pp = 0, ee = 0;
+    for(long j = 0; j < sampleframes; j++)
+    {
+        pp += p[j] * p[j];
+        ee += e[j];
+    }
+    for(ulong k = 0; k < ncoords; k++)
+    {
+        const t_sample* v = scratch + (HOA_VECTOR_VELOCITY + k) * sampleframes;
+        const t_sample* n = scratch + (HOA_VECTOR_INTENSITY + k) * sampleframes;
+        t_sample pv = 0, nn = 0;
+        for(long j = 0; j < sampleframes; j++)
+        {
+            pv += p[j] * v[j];
+            nn += n[j];
+        }
+        const t_sample velocity = pp > 0 ? pv / pp : t_sample(0.);
+        const t_sample energy   = ee > 0 ? nn / ee : t_sample(0.);
+        for(long j = 0; j < sampleframes; j++)
+        {
+            outs[k][j]           = velocity;
+            outs[ncoords + k][j] = energy;
+        }
+    }
+}
+
+//! Stores the axes of the channels with the rotation.
+static void hoa_vector_axes(Vector<Hoa2d, t_sample>* vector, t_sample* axes)
+{
+    for(ulong i = 0; i < vector->getNumberOfPlanewaves(); i++)
+    {
+        axes[i]                         = Math<t_sample>::abscissa(1., vector->getPlanewaveAzimuth(i));
+        axes[HOA_MAX_PLANEWAVES + i]    = Math<t_sample>::ordinate(1., vector->getPlanewaveAzimuth(i));
+    }
+}
+
+static void hoa_vector_axes(Vector<Hoa3d, t_sample>* vector, t_sample* axes)
+{
+    for(ulong i = 0; i < vector->getNumberOfPlanewaves(); i++)
+    {
+        axes[i]                         = Math<t_sample>::abscissa(1., vector->getPlanewaveAzimuth(i), vector->getPlanewaveElevation(i));
+        axes[HOA_MAX_PLANEWAVES + i]    = Math<t_sample>::ordinate(1., vector->getPlanewaveAzimuth(i), vector->getPlanewaveElevation(i));
+        axes[HOA_MAX_PLANEWAVES * 2 + i]= Math<t_sample>::height(1., vector->getPlanewaveAzimuth(i), vector->getPlanewaveElevation(i));
+    }
+}
+
+static ulong hoa_vector_getnchannels(int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_LONG)
+    {
+        return ulong(pd_clip_minmax(atom_getlong(argv), 1, HOA_MAX_PLANEWAVES));
+    }
+    return 4;
+}
+
+static void *hoa_vector_new(t_symbol *s, int argc, t_atom *argv)
+{
+    t_hoa_vector *x = (t_hoa_vector *)eobj_new(hoa_vector_class);
+    t_binbuf *d     = binbuf_via_atoms(argc, argv);
+
+    if(x && d)
+    {
+        x->f_vector = new Vector<Hoa2d, t_sample>(hoa_vector_getnchannels(argc, argv));
+        x->f_vector->computeRendering();
+        x->f_axes   = Signal<t_sample>::alloc(HOA_MAX_PLANEWAVES * 3);
+        x->f_scratch= Signal<t_sample>::alloc(HOA_VECTOR_SIZE * HOA_MAXBLKSIZE);
+        x->f_rate   = hoa_sym_sample;
+        hoa_vector_axes(x->f_vector, x->f_axes);
+
+        eobj_dspsetup(x, long(x->f_vector->getNumberOfPlanewaves()), 4);
+        ebox_attrprocess_viabinbuf(x, d);
+        binbuf_free(d);
+
+        return x;
+    }
+    if(d)
+    {
+        binbuf_free(d);
+    }
+
+    return NULL;
+}
+
+static void hoa_vector_perform(t_hoa_vector *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    hoa_vector_accumulate(x->f_axes, 2, ins, numins, sampleframes, x->f_scratch);
+    hoa_vector_sample(x->f_scratch, 2, sampleframes, outs);
+}
+
+static void hoa_vector_perform_block(t_hoa_vector *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    hoa_vector_accumulate(x->f_axes, 2, ins, numins, sampleframes, x->f_scratch);
+    hoa_vector_block(x->f_scratch, 2, sampleframes, outs);
+}
+
+static void hoa_vector_dsp(t_hoa_vector *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
+{
+    Signal<t_sample>::free(x->f_scratch);
+    x->f_scratch = Signal<t_sample>::alloc(ulong(HOA_VECTOR_SIZE * maxvectorsize));
+    if(x->f_rate == hoa_sym_block)
+    {
+        object_method(dsp64, gensym("dsp_add64"), x, (method)hoa_vector_perform_block, 0, NULL);
+    }
+    else
+    {
+        object_method(dsp64, gensym("dsp_add64"), x, (method)hoa_vector_perform, 0, NULL);
+    }
+}
+
+static t_pd_err hoa_vector_channels_get(t_hoa_vector *x, void *attr, int* argc, t_atom **argv)
+{
+    *argc = 1;
+    *argv = (t_atom *)malloc(size_t(*argc) * sizeof(t_atom));
+    if(*argc && *argv)
+    {
+        atom_setfloat(*argv, x->f_vector->getNumberOfPlanewaves());
+    }
+    else
+    {
+        *argc = 0;
+        *argv = NULL;
+    }
+    return 0;
+}
+
+//! Rebuilds the vector with a regular layout and resizes the signal inlets, the angles and the offset can follow.
+static t_pd_err hoa_vector_channels_set(t_hoa_vector *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        const ulong d = ulong(pd_clip_minmax(atom_getfloat(argv), 1, HOA_MAX_PLANEWAVES));
+        if(d != x->f_vector->getNumberOfPlanewaves())
+        {
+            int dspState = canvas_suspend_dsp();
+            delete x->f_vector;
+            x->f_vector = new Vector<Hoa2d, t_sample>(d);
+            x->f_vector->computeRendering();
+            hoa_vector_axes(x->f_vector, x->f_axes);
+            eobj_resize_inputs(x, long(d));
+            canvas_update_dsp();
+            canvas_resume_dsp(dspState);
+        }
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_angles_set(t_hoa_vector *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv)
+    {
+        int dspState = canvas_suspend_dsp();
+        for(long i = 0; i < argc && i < (long)x->f_vector->getNumberOfPlanewaves(); i++)
+        {
+            if(atom_gettype(argv+i) == A_FLOAT)
+                x->f_vector->setPlanewaveAzimuth(ulong(i), atom_getfloat(argv+i) / 360. * HOA_2PI);
+        }
+        x->f_vector->computeRendering();
+        hoa_vector_axes(x->f_vector, x->f_axes);
+        canvas_resume_dsp(dspState);
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_angles_get(t_hoa_vector *x, void *attr, int* argc, t_atom **argv)
+{
+    *argc = long(x->f_vector->getNumberOfPlanewaves());
+    *argv = (t_atom *)malloc(size_t(*argc) * sizeof(t_atom));
+    if(*argc && *argv)
+    {
+        for(int i = 0; i < *argc; i++)
+        {
+            atom_setfloat(*argv+i, x->f_vector->getPlanewaveAzimuth(ulong(i), false) * 360. / HOA_2PI);
+        }
+    }
+    else
+    {
+        *argc = 0;
+        *argv = NULL;
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_offset_set(t_hoa_vector *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        int dspState = canvas_suspend_dsp();
+        x->f_vector->setPlanewavesRotation(0., 0., atom_getfloat(argv) / 360. * HOA_2PI);
+        x->f_vector->computeRendering();
+        hoa_vector_axes(x->f_vector, x->f_axes);
+        canvas_resume_dsp(dspState);
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_offset_get(t_hoa_vector *x, void *attr, int* argc, t_atom **argv)
+{
+    *argc = 1;
+    *argv = (t_atom *)malloc(size_t(*argc) * sizeof(t_atom));
+    if(*argc && *argv)
+    {
+        atom_setfloat(*argv, x->f_vector->getPlanewavesRotationZ() * 360. / HOA_2PI);
+    }
+    else
+    {
+        *argc = 0;
+        *argv = NULL;
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_rate_set(t_hoa_vector *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_SYM)
+    {
+        t_symbol* rate = atom_getsym(argv) == hoa_sym_block ? hoa_sym_block : hoa_sym_sample;
+        if(rate != x->f_rate)
+        {
+            int dspState = canvas_suspend_dsp();
+            x->f_rate = rate;
+            canvas_update_dsp();
+            canvas_resume_dsp(dspState);
+        }
+    }
+    return 0;
+}
+
+static void hoa_vector_free(t_hoa_vector *x)
+{
+    eobj_dspfree(x);
+    delete x->f_vector;
+    Signal<t_sample>::free(x->f_axes);
+    Signal<t_sample>::free(x->f_scratch);
+}
+
+extern "C" void setup_hoa0x2e2d0x2evector_tilde(void)
+{
+    t_eclass* c;
+
+    c = eclass_new("hoa.2d.vector~", (method)hoa_vector_new, (method)hoa_vector_free, (short)sizeof(t_hoa_vector), 0L, A_GIMME, 0);
+    class_addcreator((t_newmethod)hoa_vector_new, gensym("hoa.vector~"), A_GIMME, 0);
+    eclass_dspinit(c);
+    eclass_addmethod(c, (method)hoa_vector_dsp,            "dsp",          A_CANT,  0);
+
+    CLASS_ATTR_LONG             (c, "channels", 0, t_hoa_vector, f_attrs);
+    CLASS_ATTR_ACCESSORS		(c, "channels", hoa_vector_channels_get, hoa_vector_channels_set);
+    CLASS_ATTR_ORDER            (c, "channels", 0, "1");
+    CLASS_ATTR_CATEGORY			(c, "channels", 0, "Planewaves");
+    CLASS_ATTR_LABEL            (c, "channels", 0, "Number of Channels");
+    CLASS_ATTR_SAVE             (c, "channels", 0);
+
+    CLASS_ATTR_DOUBLE_VARSIZE	(c, "angles",0, t_hoa_vector, f_attrs, f_attrs, HOA_MAX_PLANEWAVES);
+    CLASS_ATTR_ACCESSORS		(c, "angles", hoa_vector_angles_get, hoa_vector_angles_set);
+    CLASS_ATTR_ORDER            (c, "angles", 0, "2");
+    CLASS_ATTR_CATEGORY			(c, "angles", 0, "Planewaves");
+    CLASS_ATTR_LABEL			(c, "angles", 0, "Angles of Loudspeakers");
+    CLASS_ATTR_SAVE             (c, "angles", 0);
+
+    CLASS_ATTR_DOUBLE           (c, "offset", 0, t_hoa_vector, f_attrs);
+    CLASS_ATTR_ACCESSORS		(c, "offset", hoa_vector_offset_get, hoa_vector_offset_set);
+    CLASS_ATTR_ORDER            (c, "offset", 0, "3");
+    CLASS_ATTR_CATEGORY			(c, "offset", 0, "Planewaves");
+    CLASS_ATTR_LABEL            (c, "offset", 0, "Offset of Channels");
+    CLASS_ATTR_SAVE             (c, "offset", 0);
+
+    CLASS_ATTR_SYMBOL           (c, "rate", 0, t_hoa_vector, f_rate);
+    CLASS_ATTR_ACCESSORS		(c, "rate", NULL, hoa_vector_rate_set);
+    CLASS_ATTR_CATEGORY			(c, "rate", 0, "Behavior");
+    CLASS_ATTR_LABEL            (c, "rate", 0, "Output Rate");
+    CLASS_ATTR_DEFAULT          (c, "rate", 0, "sample");
+    CLASS_ATTR_SAVE             (c, "rate", 0);
+    CLASS_ATTR_STYLE            (c, "rate", 0, "menu");
+    CLASS_ATTR_ITEMS            (c, "rate", 0, "sample block");
+
+    eclass_register(CLASS_OBJ, c);
+    hoa_vector_class = c;
+}
+
+static void *hoa_vector_3d_new(t_symbol *s, int argc, t_atom *argv)
+{
+    t_hoa_vector_3d *x = (t_hoa_vector_3d *)eobj_new(hoa_vector_3d_class);
+    t_binbuf *d         = binbuf_via_atoms(argc, argv);
+
+    if(x && d)
+    {
+        x->f_vector = new Vector<Hoa3d, t_sample>(hoa_vector_getnchannels(argc, argv));
+        x->f_vector->computeRendering();
+        x->f_axes   = Signal<t_sample>::alloc(HOA_MAX_PLANEWAVES * 3);
+        x->f_scratch= Signal<t_sample>::alloc(HOA_VECTOR_SIZE * HOA_MAXBLKSIZE);
+        x->f_rate   = hoa_sym_sample;
+        hoa_vector_axes(x->f_vector, x->f_axes);
+
+        eobj_dspsetup(x, long(x->f_vector->getNumberOfPlanewaves()), 6);
+        ebox_attrprocess_viabinbuf(x, d);
+        binbuf_free(d);
+
+        return x;
+    }
+    if(d)
+    {
+        binbuf_free(d);
+    }
+
+    return NULL;
+}
+
+static void hoa_vector_3d_perform(t_hoa_vector_3d *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    hoa_vector_accumulate(x->f_axes, 3, ins, numins, sampleframes, x->f_scratch);
+    hoa_vector_sample(x->f_scratch, 3, sampleframes, outs);
+}
+
+static void hoa_vector_3d_perform_block(t_hoa_vector_3d *x, t_object *dsp64, t_sample **ins, long numins, t_sample **outs, long numouts, long sampleframes, long flags, void *userparam)
+{
+    hoa_vector_accumulate(x->f_axes, 3, ins, numins, sampleframes, x->f_scratch);
+    hoa_vector_block(x->f_scratch, 3, sampleframes, outs);
+}
+
+static void hoa_vector_3d_dsp(t_hoa_vector_3d *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
+{
+    Signal<t_sample>::free(x->f_scratch);
+    x->f_scratch = Signal<t_sample>::alloc(ulong(HOA_VECTOR_SIZE * maxvectorsize));
+    if(x->f_rate == hoa_sym_block)
+    {
+        object_method(dsp64, gensym("dsp_add64"), x, (method)hoa_vector_3d_perform_block, 0, NULL);
+    }
+    else
+    {
+        object_method(dsp64, gensym("dsp_add64"), x, (method)hoa_vector_3d_perform, 0, NULL);
+    }
+}
+
+static t_pd_err hoa_vector_3d_channels_get(t_hoa_vector_3d *x, void *attr, int* argc, t_atom **argv)
+{
+    *argc = 1;
+    *argv = (t_atom *)malloc(size_t(*argc) * sizeof(t_atom));
+    if(*argc && *argv)
+    {
+        atom_setfloat(*argv, x->f_vector->getNumberOfPlanewaves());
+    }
+    else
+    {
+        *argc = 0;
+        *argv = NULL;
+    }
+    return 0;
+}
+
+//! Rebuilds the vector with the default layout and resizes the signal inlets, the angles and the offset can follow.
+static t_pd_err hoa_vector_3d_channels_set(t_hoa_vector_3d *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_FLOAT)
+    {
+        const ulong d = ulong(pd_clip_minmax(atom_getfloat(argv), 1, HOA_MAX_PLANEWAVES));
+        if(d != x->f_vector->getNumberOfPlanewaves())
+        {
+            int dspState = canvas_suspend_dsp();
+            delete x->f_vector;
+            x->f_vector = new Vector<Hoa3d, t_sample>(d);
+            x->f_vector->computeRendering();
+            hoa_vector_axes(x->f_vector, x->f_axes);
+            eobj_resize_inputs(x, long(d));
+            canvas_update_dsp();
+            canvas_resume_dsp(dspState);
+        }
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_3d_angles_set(t_hoa_vector_3d *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv)
+    {
+        int dspState = canvas_suspend_dsp();
+        for(long i = 0, j = 0; j < argc && i < (long)x->f_vector->getNumberOfPlanewaves(); j++)
+        {
+            if(atom_gettype(argv+j) == A_FLOAT)
+            {
+                if(j%2)
+                {
+                    x->f_vector->setPlanewaveElevation(ulong(i), atom_getfloat(argv+j) / 360. * HOA_2PI);
+                    i++;
+                }
+                else
+                {
+                    x->f_vector->setPlanewaveAzimuth(ulong(i), atom_getfloat(argv+j) / 360. * HOA_2PI);
+                }
+            }
+        }
+        x->f_vector->computeRendering();
+        hoa_vector_axes(x->f_vector, x->f_axes);
+        canvas_resume_dsp(dspState);
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_3d_angles_get(t_hoa_vector_3d *x, void *attr, int* argc, t_atom **argv)
+{
+    *argc = int(x->f_vector->getNumberOfPlanewaves() * 2);
+    *argv = (t_atom *)malloc(size_t(*argc) * sizeof(t_atom));
+    if(*argc && *argv)
+    {
+        for(ulong i = 0; i < x->f_vector->getNumberOfPlanewaves(); i++)
+        {
+            atom_setfloat(*argv+i*2, x->f_vector->getPlanewaveAzimuth(i, false) * 360. / HOA_2PI);
+            atom_setfloat(*argv+i*2+1, x->f_vector->getPlanewaveElevation(i, false) * 360. / HOA_2PI);
+        }
+    }
+    else
+    {
+        *argc = 0;
+        *argv = NULL;
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_3d_offset_set(t_hoa_vector_3d *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv)
+    {
+        double ax, ay, az;
+        int dspState = canvas_suspend_dsp();
+        if(atom_gettype(argv) == A_FLOAT)
+            ax = atom_getfloat(argv) / 360. * HOA_2PI;
+        else
+            ax = x->f_vector->getPlanewavesRotationX();
+        if(argc > 1 && atom_gettype(argv+1) == A_FLOAT)
+            ay = atom_getfloat(argv+1) / 360. * HOA_2PI;
+        else
+            ay = x->f_vector->getPlanewavesRotationY();
+        if(argc > 2 &&  atom_gettype(argv+2) == A_FLOAT)
+            az = atom_getfloat(argv+2) / 360. * HOA_2PI;
+        else
+            az = x->f_vector->getPlanewavesRotationZ();
+        x->f_vector->setPlanewavesRotation(ax, ay, az);
+        x->f_vector->computeRendering();
+        hoa_vector_axes(x->f_vector, x->f_axes);
+        canvas_resume_dsp(dspState);
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_3d_offset_get(t_hoa_vector_3d *x, void *attr, int* argc, t_atom **argv)
+{
+    *argc = 3;
+    *argv = (t_atom *)malloc(size_t(*argc) * sizeof(t_atom));
+    if(*argc && *argv)
+    {
+        atom_setfloat(*argv, x->f_vector->getPlanewavesRotationX() * 360. / HOA_2PI);
+        atom_setfloat(*argv+1, x->f_vector->getPlanewavesRotationY() * 360. / HOA_2PI);
+        atom_setfloat(*argv+2, x->f_vector->getPlanewavesRotationZ() * 360. / HOA_2PI);
+    }
+    else
+    {
+        *argc = 0;
+        *argv = NULL;
+    }
+    return 0;
+}
+
+static t_pd_err hoa_vector_3d_rate_set(t_hoa_vector_3d *x, void *attr, int argc, t_atom *argv)
+{
+    if(argc && argv && atom_gettype(argv) == A_SYM)
+    {
+        t_symbol* rate = atom_getsym(argv) == hoa_sym_block ? hoa_sym_block : hoa_sym_sample;
+        if(rate != x->f_rate)
+        {
+            int dspState = canvas_suspend_dsp();
+            x->f_rate = rate;
+            canvas_update_dsp();
+            canvas_resume_dsp(dspState);
+        }
+    }
+    return 0;
+}
+
+static void hoa_vector_3d_free(t_hoa_vector_3d *x)
+{
+    eobj_dspfree(x);
+    delete x->f_vector;
+    Signal<t_sample>::free(x->f_axes);
+    Signal<t_sample>::free(x->f_scratch);
+}
+
+extern "C" void setup_hoa0x2e3d0x2evector_tilde(void)
+{
+    t_eclass* c = eclass_new("hoa.3d.vector~", (method)hoa_vector_3d_new, (method)hoa_vector_3d_free, (short)sizeof(t_hoa_vector_3d), 0L, A_GIMME, 0);
+
+    eclass_dspinit(c);
+    eclass_addmethod(c, (method)hoa_vector_3d_dsp,         "dsp",          A_CANT,  0);
+
+    CLASS_ATTR_LONG             (c, "channels", 0, t_hoa_vector_3d, f_attrs);
+    CLASS_ATTR_ACCESSORS		(c, "channels", hoa_vector_3d_channels_get, hoa_vector_3d_channels_set);
+    CLASS_ATTR_ORDER            (c, "channels", 0, "1");
+    CLASS_ATTR_CATEGORY			(c, "channels", 0, "Planewaves");
+    CLASS_ATTR_LABEL            (c, "channels", 0, "Number of Channels");
+    CLASS_ATTR_SAVE             (c, "channels", 0);
+
+    CLASS_ATTR_DOUBLE_VARSIZE	(c, "angles",0, t_hoa_vector_3d, f_attrs, f_attrs, HOA_MAX_PLANEWAVES*2);
+    CLASS_ATTR_ACCESSORS		(c, "angles", hoa_vector_3d_angles_get, hoa_vector_3d_angles_set);
+    CLASS_ATTR_ORDER            (c, "angles", 0, "2");
+    CLASS_ATTR_CATEGORY			(c, "angles", 0, "Planewaves");
+    CLASS_ATTR_LABEL			(c, "angles", 0, "Angles of Loudspeakers");
+    CLASS_ATTR_SAVE             (c, "angles", 0);
+
+    CLASS_ATTR_DOUBLE_ARRAY     (c, "offset", 0, t_hoa_vector_3d, f_attrs, 3);
+    CLASS_ATTR_ACCESSORS		(c, "offset", hoa_vector_3d_offset_get, hoa_vector_3d_offset_set);
+    CLASS_ATTR_ORDER            (c, "offset", 0, "3");
+    CLASS_ATTR_CATEGORY			(c, "offset", 0, "Planewaves");
+    CLASS_ATTR_LABEL            (c, "offset", 0, "Offset of Channels");
+    CLASS_ATTR_SAVE             (c, "offset", 0);
+
+    CLASS_ATTR_SYMBOL           (c, "rate", 0, t_hoa_vector_3d, f_rate);
+    CLASS_ATTR_ACCESSORS		(c, "rate", NULL, hoa_vector_3d_rate_set);
+    CLASS_ATTR_CATEGORY			(c, "rate", 0, "Behavior");
+    CLASS_ATTR_LABEL            (c, "rate", 0, "Output Rate");
+    CLASS_ATTR_DEFAULT          (c, "rate", 0, "sample");
+    CLASS_ATTR_SAVE             (c, "rate", 0);
+    CLASS_ATTR_STYLE            (c, "rate", 0, "menu");
+    CLASS_ATTR_ITEMS            (c, "rate", 0, "sample block");
+
+    eclass_register(CLASS_OBJ, c);
+    hoa_vector_3d_class = c;
+}
@@ -5,9 +5,324 @@
 */
 
 #include "hoa.library.hpp"
+#include <vector>
+#include <map>
+#include <algorithm>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
 
 char hoaversion[] = "Beta 2.2";
 
+typedef struct _hoa_frame_client
+{
+    t_ebox*     f_box;
+    t_method    f_tick;
+    long*       f_interval;
+    double      f_elapsed;
+} t_hoa_frame_client;
+
+static std::vector<t_hoa_frame_client>  hoa_frame_clients;
+static std::vector<t_ebox*>             hoa_frame_dirties;
+static t_clock*                         hoa_frame_clock     = NULL;
+static bool                             hoa_frame_running   = false;
+static double                           hoa_frame_last      = 0.;
+static double                           hoa_frame_stride    = 1.;
+
+//! The time, the drawing commands and the points of the redraws of the scheduler for each class, posted by the message "stats" sent to hoa.frame.
+typedef struct _hoa_frame_stat
+{
+    t_symbol*   f_name;
+    long        f_count;
+    double      f_sum;
+    double      f_max;
+    double      f_commands;
+    double      f_points;
+} t_hoa_frame_stat;
+
+static std::vector<t_hoa_frame_stat>    hoa_frame_stats;
+static t_class*                         hoa_frame_class     = NULL;
+static bool                             hoa_frame_recording = false;
+
+static void hoa_frame_record(t_symbol* name, const double duration, const long commands, const long points)
+{
+    for(size_t i = 0; i < hoa_frame_stats.size(); i++)
+    {
+        if(hoa_frame_stats[i].f_name == name)
+        {
+            hoa_frame_stats[i].f_count++;
+            hoa_frame_stats[i].f_sum += duration;
+            hoa_frame_stats[i].f_max = std::max(hoa_frame_stats[i].f_max, duration);
+            hoa_frame_stats[i].f_commands += double(commands);
+            hoa_frame_stats[i].f_points += double(points);
+            return;
+        }
+    }
+    t_hoa_frame_stat stat = {name, 1, duration, duration, double(commands), double(points)};
+    hoa_frame_stats.push_back(stat);
+}
+
+static void hoa_frame_stats_post(t_pd* dummy)
+{
+    post("hoa.frame: stride %.2f, %lu clients%s", hoa_frame_stride, (unsigned long)hoa_frame_clients.size(), hoa_frame_recording && sys_nogui ? ", recording" : "");
+    for(size_t i = 0; i < hoa_frame_stats.size(); i++)
+    {
+        const t_hoa_frame_stat& stat = hoa_frame_stats[i];
+        const double count = double(stat.f_count);
+        post("hoa.frame: %s %ld redraws, mean %.3f ms, max %.3f ms, %.1f commands, %.1f points", stat.f_name->s_name, stat.f_count, stat.f_sum / count, stat.f_max, stat.f_commands / count, stat.f_points / count);
+    }
+}
+
+static void hoa_frame_stats_clear(t_pd* dummy)
+{
+    hoa_frame_stats.clear();
+}
+
+//! Turns the recording of the redraws without GUI on or off, the widgets are then ticked and painted as if their canvas was visible.
+static void hoa_frame_stats_record(t_pd* dummy, t_float state)
+{
+    hoa_frame_recording = state != 0;
+}
+
+static void hoa_frame_setup(void)
+{
+    if(!hoa_frame_class)
+    {
+        hoa_frame_class = class_new(gensym("hoa.frame"), 0, 0, sizeof(t_pd), CLASS_PD, A_NULL, 0);
+        class_addmethod(hoa_frame_class, (t_method)hoa_frame_stats_post, gensym("stats"), A_NULL, 0);
+        class_addmethod(hoa_frame_class, (t_method)hoa_frame_stats_clear, hoa_sym_clear, A_NULL, 0);
+        class_addmethod(hoa_frame_class, (t_method)hoa_frame_stats_record, gensym("record"), A_FLOAT, 0);
+        pd_bind(pd_new(hoa_frame_class), gensym("hoa.frame"));
+    }
+}
+
+static bool hoa_frame_isvisible(t_ebox* x)
+{
+    return !sys_nogui && eobj_getcanvas(x) && glist_isvisible(eobj_getcanvas(x));
+}
+
+//! Returns true if the widget must be ticked and drawn, on a visible canvas or without GUI when the redraws are recorded.
+static bool hoa_frame_isdrawable(t_ebox* x)
+{
+    return (sys_nogui && hoa_frame_recording) || hoa_frame_isvisible(x);
+}
+
+//! Redraws a widget and records the time, the commands and the points.
+/** With a GUI the widget is redrawn by the wrapper. Without GUI the paint method is called directly, the layers are filled as usual and the commands that the wrapper would send are dropped by Pd. In both cases the commands are the graphical objects of the layers that were invalid or created by the paint method, and the points are their coordinates.
+ */
+static void hoa_frame_paint(t_ebox* x)
+{
+    std::vector<char> invalids(size_t(x->b_number_of_layers));
+    for(long i = 0; i < x->b_number_of_layers; i++)
+    {
+        invalids[size_t(i)] = x->b_layers[i].e_state == EGRAPHICS_INVALID;
+    }
+
+    const double time = sys_getrealtime();
+    if(sys_nogui)
+    {
+        t_eclass* c = eobj_getclass(x);
+        if(c->c_widget.w_paint)
+        {
+            c->c_widget.w_paint(x, (t_object *)eobj_getcanvas(x));
+        }
+    }
+    else
+    {
+        ebox_redraw(x);
+    }
+    const double duration = (sys_getrealtime() - time) * 1000.;
+
+    long commands = 0, points = 0;
+    for(long i = 0; i < x->b_number_of_layers; i++)
+    {
+        if(size_t(i) >= invalids.size() || invalids[size_t(i)])
+        {
+            const t_elayer& layer = x->b_layers[i];
+            for(long j = 0; j < layer.e_number_objects; j++)
+            {
+                points += long(layer.e_objects[j].e_npoints);
+            }
+            commands += long(layer.e_number_objects);
+        }
+    }
+    hoa_frame_record(eobj_getclassname(x), duration, commands, points);
+}
+
+static void hoa_frame_tick(void* dummy)
+{
+    const double start = sys_getrealtime();
+    hoa_frame_running = false;
+    hoa_frame_last    = clock_getlogicaltime();
+    if(canvas_dspstate)
+    {
+        for(size_t i = 0; i < hoa_frame_clients.size(); i++)
+        {
+            t_hoa_frame_client& client = hoa_frame_clients[i];
+            client.f_elapsed += HOA_FRAME_INTERVAL;
+            if(client.f_elapsed >= double(*client.f_interval) * hoa_frame_stride)
+            {
+                client.f_elapsed = 0.;
+                if(hoa_frame_isdrawable(client.f_box))
+                {
+                    ((void (*)(t_ebox *))client.f_tick)(client.f_box);
+                }
+            }
+        }
+    }
+    for(size_t i = 0; i < hoa_frame_dirties.size(); i++)
+    {
+        if(hoa_frame_isdrawable(hoa_frame_dirties[i]))
+        {
+            hoa_frame_paint(hoa_frame_dirties[i]);
+        }
+    }
+    hoa_frame_dirties.clear();
+
+    const double duration = (sys_getrealtime() - start) * 1000.;
+    if(duration > HOA_FRAME_BUDGET)
+    {
+        hoa_frame_stride = std::min(hoa_frame_stride * 1.5, 8.);
+    }
+    else if(duration < HOA_FRAME_BUDGET * 0.5)
+    {
+        hoa_frame_stride = std::max(hoa_frame_stride * 0.95, 1.);
+    }
+    if(canvas_dspstate && !hoa_frame_clients.empty())
+    {
+        hoa_frame_running = true;
+        clock_delay(hoa_frame_clock, HOA_FRAME_INTERVAL);
+    }
+}
+
+static void hoa_frame_wake(void)
+{
+    if(!hoa_frame_clock)
+    {
+        hoa_frame_clock = clock_new(NULL, (t_method)hoa_frame_tick);
+    }
+    if(!hoa_frame_running)
+    {
+        hoa_frame_running = true;
+        const double since = clock_gettimesince(hoa_frame_last);
+        clock_delay(hoa_frame_clock, since < HOA_FRAME_INTERVAL ? HOA_FRAME_INTERVAL - since : 0.);
+    }
+}
+
+void hoa_frame_register(t_ebox* x, t_method tick, long* interval)
+{
+    t_hoa_frame_client client = {x, tick, interval, 0.};
+    hoa_frame_clients.push_back(client);
+}
+
+void hoa_frame_unregister(t_ebox* x)
+{
+    for(size_t i = 0; i < hoa_frame_clients.size(); i++)
+    {
+        if(hoa_frame_clients[i].f_box == x)
+        {
+            hoa_frame_clients.erase(hoa_frame_clients.begin() + i);
+            break;
+        }
+    }
+    hoa_frame_dirties.erase(std::remove(hoa_frame_dirties.begin(), hoa_frame_dirties.end(), x), hoa_frame_dirties.end());
+}
+
+void hoa_frame_start(void)
+{
+    hoa_frame_wake();
+}
+
+bool hoa_frame_isheadless(void)
+{
+    return sys_nogui && !hoa_frame_recording;
+}
+
+void hoa_frame_redraw(t_ebox* x)
+{
+    if(sys_nogui && !hoa_frame_recording)
+    {
+        return;
+    }
+    if(std::find(hoa_frame_dirties.begin(), hoa_frame_dirties.end(), x) == hoa_frame_dirties.end())
+    {
+        hoa_frame_dirties.push_back(x);
+    }
+    hoa_frame_wake();
+}
+
+t_hoa_setmultiout hoa_signal_setmultiout(void)
+{
+    static bool                 resolved = false;
+    static t_hoa_setmultiout    function = NULL;
+#ifdef CLASS_MULTICHANNEL
+    if(!resolved)
+    {
+        int major = 0, minor = 0, bugfix = 0;
+        sys_getversion(&major, &minor, &bugfix);
+        if(major > 0 || minor >= 54)
+        {
+#ifdef _WIN32
+            function = (t_hoa_setmultiout)GetProcAddress(GetModuleHandleA("pd.dll"), "signal_setmultiout");
+#else
+            function = (t_hoa_setmultiout)dlsym(RTLD_DEFAULT, "signal_setmultiout");
+#endif
+        }
+    }
+#endif
+    resolved = true;
+    return function;
+}
+
+//! The snapshots by key. They aren't stored in the s_thing of the symbols, which must stay a t_pd for pd_bind.
+static std::map<t_symbol*, HoaMapSnapshot*> hoa_map_snapshots;
+
+static t_symbol* hoa_map_snapshot_name(t_object* x, t_symbol* name)
+{
+    char text[MAXPDSTRING];
+    t_canvas *canvas = canvas_getrootfor(eobj_getcanvas(x));
+    if(!canvas || !name || name == hoa_sym_nothing || name == hoa_sym_null)
+    {
+        return NULL;
+    }
+    snprintf(text, MAXPDSTRING, "p%p_%s_mapsnapshot", (void *)canvas, name->s_name);
+    return gensym(text);
+}
+
+HoaMapSnapshot* hoa_map_snapshot_acquire(t_object* x, t_symbol* name)
+{
+    t_symbol* key = hoa_map_snapshot_name(x, name);
+    if(!key)
+    {
+        return NULL;
+    }
+    HoaMapSnapshot*& snapshot = hoa_map_snapshots[key];
+    if(!snapshot)
+    {
+        snapshot = new HoaMapSnapshot();
+    }
+    snapshot->m_references++;
+    return snapshot;
+}
+
+void hoa_map_snapshot_release(t_object* x, t_symbol* name)
+{
+    t_symbol* key = hoa_map_snapshot_name(x, name);
+    std::map<t_symbol*, HoaMapSnapshot*>::iterator it = key ? hoa_map_snapshots.find(key) : hoa_map_snapshots.end();
+    if(it != hoa_map_snapshots.end())
+    {
+        HoaMapSnapshot* snapshot = it->second;
+        if(!--snapshot->m_references)
+        {
+            hoa_map_snapshots.erase(it);
+            delete snapshot;
+        }
+    }
+}
+
 static t_eclass *cream_class;
 
 static void *hoa_new(t_symbol *s)
@@ -32,6 +347,8 @@ extern "C" void hoa_setup(void)
         eobj_free(obj);
     }
 
+    hoa_frame_setup();
+
     // HOA COMMON //
     setup_hoa0x2econnect();
     setup_hoa0x2edac_tilde();
@@ -58,6 +375,7 @@ extern "C" void hoa_setup(void)
     setup_hoa0x2e2d0x2espace();
     setup_hoa0x2e2d0x2ewider_tilde();
     setup_hoa0x2e2d0x2eexchanger_tilde();
+    setup_hoa0x2e2d0x2evector_tilde();
 
     // HOA 3D //
     setup_hoa0x2e3d0x2edecoder_tilde();
@@ -68,6 +386,7 @@ extern "C" void hoa_setup(void)
 	setup_hoa0x2e3d0x2emeter_tilde();
     setup_hoa0x2e3d0x2escope_tilde();
     setup_hoa0x2e3d0x2eexchanger_tilde();
+    setup_hoa0x2e3d0x2evector_tilde();
 
     epd_add_folder("Hoa", "patchers");
     epd_add_folder("Hoa", "clippings");
@@ -11,6 +11,8 @@ extern "C"
 {
 #include "ThirdParty/CicmWrapper/Sources/cicm_wrapper.h"
 }
+#include <atomic>
+#include <vector>
 
 #define HOA_MAX_PLANEWAVES      128
 #define HOA_MAXBLKSIZE          8192
@@ -19,6 +21,10 @@ extern "C"
 #define HOA_CONTRAST_LIGHTER    0.06f
 #define HOA_CONTRAST_DARKER     0.14f
 #define HOA_DISPLAY_NPOINTS     180
+#define HOA_FRAME_INTERVAL      20
+#define HOA_FRAME_BUDGET        5.
+#define HOA_SNAPSHOT_MAXPERIODS 32
+#define HOA_MAP_MAXINDEX        65536
 
 typedef struct _hoa_in
 {
@@ -38,6 +44,8 @@ typedef struct _hoa_in_tilde
     t_edspobj   f_obj;
     t_sample*   f_signal;
     int         f_extra;
+    t_sample**  f_signals;
+    int         f_nchannels;
 } t_hoa_in_tilde;
 
 typedef struct _hoa_out_tilde
@@ -45,6 +53,9 @@ typedef struct _hoa_out_tilde
     t_edspobj   f_obj;
     t_sample*   f_signal;
     int         f_extra;
+    t_sample**  f_signals;
+    int         f_nchannels;
+    t_float     f_float;
 } t_hoa_out_tilde;
 
 typedef struct _hoa_thisprocess
@@ -71,6 +82,107 @@ typedef struct _hoa_thisprocess
     double      f_time;
 } t_hoa_thisprocess;
 
+//! The frame scheduler shared by the GUIs.
+/** The periodic GUIs register their tick method and a pointer to their interval, the scheduler calls them on a global frame when the DSP is on and their canvas is visible. The widgets call hoa_frame_redraw instead of ebox_redraw, all the redraws of a frame are flushed together. If a frame takes longer than HOA_FRAME_BUDGET milliseconds, the intervals are stretched until the load decreases. The time, the drawing commands and the points of the redraws are accounted for each class, the messages "stats" and "clear" sent to hoa.frame post and reset them. Without GUI, the message "record 1" makes the scheduler tick and paint the widgets anyway so they can be measured with -nogui.
+ */
+void hoa_frame_register(t_ebox* x, t_method tick, long* interval);
+void hoa_frame_unregister(t_ebox* x);
+void hoa_frame_start(void);
+void hoa_frame_redraw(t_ebox* x);
+
+/** Returns true if Pd runs without GUI (-nogui) and the redraws aren't recorded, the widgets then skip all their drawing work and only feed their data outlets.
+ */
+bool hoa_frame_isheadless(void);
+
+typedef void (*t_hoa_setmultiout)(t_signal **sig, int nchans);
+
+/** Returns the function signal_setmultiout of the running Pd or NULL if it doesn't support the multichannel signals. It's looked up at run time, so a binary built with the headers of Pd 0.54 still loads in an older Pd.
+ */
+t_hoa_setmultiout hoa_signal_setmultiout(void);
+
+//! The state of the sources of the hoa.map bound to a name, read by the hoa.map~ bound to the same name.
+/** The sources are stored by index, each one keeps the version of the snapshot at which it changed last so a reader only updates the sources newer than the version it read before. The scheduler runs the messages and the DSP chain in the same thread, a snapshot is never read while it is written.
+ */
+class HoaMapSnapshot
+{
+public:
+    struct Source
+    {
+        unsigned long   version;
+        bool            mute;
+        double          radius;
+        double          azimuth;
+        double          elevation;
+    };
+    
+    HoaMapSnapshot() : m_version(0), m_references(0) {}
+    
+    inline unsigned long getVersion() const noexcept
+    {
+        return m_version;
+    }
+    
+    //! Returns the number of entries, the entry i is the source of index i + 1.
+    inline size_t getSize() const noexcept
+    {
+        return m_sources.size();
+    }
+    
+    inline Source const& getSource(const size_t i) const noexcept
+    {
+        return m_sources[i];
+    }
+    
+    //! Writes the source of an index in the next version, the indices out of 1 to HOA_MAP_MAXINDEX are ignored.
+    inline void write(const unsigned long index, const bool mute, const double radius, const double azimuth, const double elevation)
+    {
+        if(!index || index > HOA_MAP_MAXINDEX)
+        {
+            return;
+        }
+        if(index > m_sources.size())
+        {
+            Source src = {0, true, 1., 0., 0.};
+            m_sources.resize(index, src);
+        }
+        Source& src     = m_sources[index - 1];
+        src.version     = m_version + 1;
+        src.mute        = mute;
+        src.radius      = radius;
+        src.azimuth     = azimuth;
+        src.elevation   = elevation;
+    }
+    
+    //! Mutes the source of an index in the next version if it isn't already.
+    inline void remove(const unsigned long index)
+    {
+        if(index && index <= m_sources.size() && !m_sources[index - 1].mute)
+        {
+            m_sources[index - 1].version = m_version + 1;
+            m_sources[index - 1].mute    = true;
+        }
+    }
+    
+    //! Makes the written sources visible to the readers.
+    inline void publish() noexcept
+    {
+        m_version++;
+    }
+    
+private:
+    friend HoaMapSnapshot* hoa_map_snapshot_acquire(t_object* x, t_symbol* name);
+    friend void hoa_map_snapshot_release(t_object* x, t_symbol* name);
+    
+    std::vector<Source> m_sources;
+    unsigned long       m_version;
+    unsigned long       m_references;
+};
+
+/** Returns the snapshot of a name in the patch of an object, it is created for the first object and deleted when the last one releases it.
+ */
+HoaMapSnapshot* hoa_map_snapshot_acquire(t_object* x, t_symbol* name);
+void hoa_map_snapshot_release(t_object* x, t_symbol* name);
+
 extern "C" void Hoa_setup(void);
 extern "C" void hoa_setup(void);
 
@@ -87,6 +199,7 @@ extern "C" void setup_hoa0x2ethisprocess_tilde(void);
 extern "C" void setup_hoa0x2emap(void);
 
 extern "C" void setup_hoa0x2e2d0x2ewider_tilde(void);
+extern "C" void setup_hoa0x2e2d0x2evector_tilde(void);
 extern "C" void setup_hoa0x2e2d0x2escope_tilde(void);
 extern "C" void setup_hoa0x2e2d0x2espace(void);
 extern "C" void setup_hoa0x2e2d0x2erotate_tilde(void);
@@ -108,11 +221,18 @@ extern "C" void setup_hoa0x2e3d0x2emap_tilde(void);
 extern "C" void setup_hoa0x2e3d0x2emeter_tilde(void);
 extern "C" void setup_hoa0x2e3d0x2escope_tilde(void);
 extern "C" void setup_hoa0x2e3d0x2eexchanger_tilde(void);
+extern "C" void setup_hoa0x2e3d0x2evector_tilde(void);
 
 static t_symbol* hoa_sym_none               = gensym("none");
 static t_symbol* hoa_sym_energy             = gensym("energy");
 static t_symbol* hoa_sym_velocity           = gensym("velocity");
 static t_symbol* hoa_sym_both               = gensym("both");
+static t_symbol* hoa_sym_frame              = gensym("frame");
+static t_symbol* hoa_sym_rms                = gensym("rms");
+static t_symbol* hoa_sym_peak               = gensym("peak");
+static t_symbol* hoa_sym_peaks              = gensym("peaks");
+static t_symbol* hoa_sym_sample             = gensym("sample");
+static t_symbol* hoa_sym_block              = gensym("block");
 static t_symbol* hoa_sym_clockwise          = gensym("clockwise");
 static t_symbol* hoa_sym_anticlock          = gensym("anti-clockwise");
 static t_symbol* hoa_sym_vector_layer       = gensym("vectors_layer");
@@ -145,6 +265,8 @@ static t_symbol* hoa_sym_hoa_in_tilde       = gensym("hoa.in~");
 static t_symbol* hoa_sym_hoa_out            = gensym("hoa.out");
 static t_symbol* hoa_sym_hoa_out_tilde      = gensym("hoa.out~");
 static t_symbol* hoa_sym_obj                = gensym("obj");
+static t_symbol* hoa_sym_multichannel       = gensym("@multichannel");
+static t_symbol* hoa_sym_cputime            = gensym("@cputime");
 
 
 static t_symbol* hoa_sym_order              = gensym("order");
@@ -256,5 +378,111 @@ static t_symbol* hoa_sym_zoom 						= gensym("zoom");
 static t_symbol* hoa_sym_number 					= gensym("number");
 static t_symbol* hoa_sym_index 						= gensym("index");
 
+//! Accumulates the peak of a planar signal vector.
+/** The loop is unrolled with independent accumulators so the compiler can map it on the vector unit.
+ */
+static inline t_sample hoa_signal_peak(const long n, const t_sample* in, t_sample peak)
+{
+    t_sample p0 = peak, p1 = 0, p2 = 0, p3 = 0;
+    long i = 0;
+    for(; i < (n & ~3l); i += 4)
+    {
+        const t_sample a0 = in[i] < 0 ? -in[i] : in[i];
+        const t_sample a1 = in[i+1] < 0 ? -in[i+1] : in[i+1];
+        const t_sample a2 = in[i+2] < 0 ? -in[i+2] : in[i+2];
+        const t_sample a3 = in[i+3] < 0 ? -in[i+3] : in[i+3];
+        p0 = a0 > p0 ? a0 : p0;
+        p1 = a1 > p1 ? a1 : p1;
+        p2 = a2 > p2 ? a2 : p2;
+        p3 = a3 > p3 ? a3 : p3;
+    }
+    for(; i < n; i++)
+    {
+        const t_sample a0 = in[i] < 0 ? -in[i] : in[i];
+        p0 = a0 > p0 ? a0 : p0;
+    }
+    p0 = p1 > p0 ? p1 : p0;
+    p2 = p3 > p2 ? p3 : p2;
+    return p2 > p0 ? p2 : p0;
+}
+
+//! Accumulates the sum of the squares of a planar signal vector.
+static inline t_sample hoa_signal_sumsquares(const long n, const t_sample* in, t_sample sum)
+{
+    t_sample s0 = sum, s1 = 0, s2 = 0, s3 = 0;
+    long i = 0;
+    for(; i < (n & ~3l); i += 4)
+    {
+        s0 += in[i] * in[i];
+        s1 += in[i+1] * in[i+1];
+        s2 += in[i+2] * in[i+2];
+        s3 += in[i+3] * in[i+3];
+    }
+    for(; i < n; i++)
+    {
+        s0 += in[i] * in[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+
+//! A wait-free triple buffer that hands the snapshots of a perform method over to a GUI tick.
+/** The writer owns the back buffer, fills it and publishes it. The reader gets the latest complete snapshot. Neither side ever waits on the other, so the reader can run on another thread than the DSP. A writer that accumulates should keep accumulating while the last snapshot is pending, so no interval is lost when the reader is slower.
+ */
+class HoaTripleBuffer
+{
+public:
+    HoaTripleBuffer(const size_t size) : m_size(size), m_back(0), m_middle(1), m_front(2)
+    {
+        m_buffers = new t_sample[size * 3]();
+    }
+    
+    ~HoaTripleBuffer()
+    {
+        delete [] m_buffers;
+    }
+    
+    inline size_t getSize() const noexcept
+    {
+        return m_size;
+    }
+    
+    //! Returns the buffer owned by the writer.
+    inline t_sample* write() noexcept
+    {
+        return m_buffers + m_back * m_size;
+    }
+    
+    //! Publishes the buffer of the writer and gives it an unused one.
+    inline void publish() noexcept
+    {
+        m_back = m_middle.exchange(m_back | fresh) & 3;
+    }
+    
+    //! Returns true if the last published buffer was not read yet.
+    inline bool pending() const noexcept
+    {
+        return m_middle.load() & fresh;
+    }
+    
+    //! Returns the latest published buffer, fresh is true if it was not read before.
+    inline t_sample const* read(bool& isfresh) noexcept
+    {
+        isfresh = m_middle.load() & fresh;
+        if(isfresh)
+        {
+            m_front = m_middle.exchange(m_front) & 3;
+        }
+        return m_buffers + m_front * m_size;
+    }
+    
+private:
+    static const int    fresh = 4;
+    const size_t        m_size;
+    t_sample*           m_buffers;
+    int                 m_back;
+    std::atomic<int>    m_middle;
+    int                 m_front;
+};
 
 #endif